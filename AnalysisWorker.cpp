@@ -0,0 +1,141 @@
+#include "AnalysisWorker.h"
+#include "Tablebase.h"
+
+using namespace std;
+
+AnalysisWorker::AnalysisWorker(const Game& start, const EngineOptions& opts, const SearchLimits& searchLimits,
+                               int side, bool analyse)
+    : outstanding(0), analysing(false), game(start), engine(tt, opts.threads), rng(random_device()()),
+      limits(searchLimits), computerSide(side), analysis(analyse), analysedKey(0) {
+    tt.resize(opts.hashMb);
+    engine.setUseNnue(setupNnue(opts));
+    setupBook(opts, book);
+    setupTablebases(opts);
+    if (engineToMove()) {
+        outstanding = 1; // the engine opens
+    }
+    thread = std::thread([this] { run(); });
+}
+
+AnalysisWorker::~AnalysisWorker() {
+    AnalysisJob quit = { JOB_QUIT, 0, 0, 0 };
+    submit(quit);
+    thread.join();
+}
+
+bool AnalysisWorker::busy() const {
+    return outstanding.load(memory_order_acquire) > 0 || analysing.load(memory_order_acquire);
+}
+
+void AnalysisWorker::submitMove(Square from, Square to, PieceType promo) {
+    outstanding.fetch_add(1, memory_order_relaxed);
+    AnalysisJob job = { JOB_MOVE, uint8_t(from), uint8_t(to), uint8_t(promo) };
+    submit(job);
+}
+
+void AnalysisWorker::submit(const AnalysisJob& job) {
+    while (!jobs.push(job)) {
+        this_thread::yield();
+    }
+    engine.stop(); // a running analysis gives way
+    lock_guard<mutex> lock(wakeMutex);
+    wakeCv.notify_one();
+}
+
+// move results must not be lost, the UI drains the queue every frame
+void AnalysisWorker::post(const AnalysisResult& r) {
+    while (!results.push(r)) {
+        this_thread::yield();
+    }
+}
+
+void AnalysisWorker::postMove(MoveResult result, bool byEngine) {
+    AnalysisResult r;
+    r.type = RESULT_MOVE;
+    r.byEngine = byEngine;
+    r.result = result;
+    game.save(r.game);
+    r.legal = game.legalMoves();
+    post(r);
+}
+
+void AnalysisWorker::postInfo(const SearchInfo& info) {
+    // a stop() that came before think() reset the flag is caught here: the
+    // first iteration reports within microseconds
+    if (!jobs.empty()) {
+        engine.stop();
+    }
+    AnalysisResult r;
+    r.type = RESULT_INFO;
+    r.line = formatInfo(info);
+    results.push(r); // info lines may be dropped when the UI lags
+}
+
+bool AnalysisWorker::engineToMove() const {
+    return computerSide == game.sideToMove() && !game.isOver();
+}
+
+void AnalysisWorker::playEngineMove() {
+    // known openings and endings are played from the book and the
+    // endgame tables without a search
+    Position pos = game.position();
+    Move m = book.isOpen() ? book.pick(pos, rng()) : MOVE_NONE;
+    string source = "book";
+    if (m == MOVE_NONE) {
+        m = tbBestMove(pos);
+        source = "tablebase";
+    }
+    if (m != MOVE_NONE) {
+        AnalysisResult info;
+        info.type = RESULT_INFO;
+        info.line = "info string " + source + " move " + moveToString(m);
+        results.push(info);
+    }
+    else {
+        m = engine.think(game.position(), limits, [this](const SearchInfo& info) {
+            postInfo(info);
+        }).bestMove;
+    }
+    postMove(game.applyMove(m), true);
+}
+
+void AnalysisWorker::analyse() {
+    analysedKey = game.position().key();
+    analysing.store(true, memory_order_relaxed);
+    SearchLimits infinite;
+    engine.think(game.position(), infinite, [this](const SearchInfo& info) {
+        postInfo(info);
+    });
+    analysing.store(false, memory_order_release);
+}
+
+void AnalysisWorker::run() {
+    if (engineToMove()) {
+        playEngineMove();
+        outstanding.fetch_sub(1, memory_order_release);
+    }
+
+    while (true) {
+        AnalysisJob job;
+        if (jobs.pop(job)) {
+            if (job.type == JOB_QUIT) {
+                return;
+            }
+            MoveResult result = game.applyMove(Square(job.from), Square(job.to), PieceType(job.promo));
+            postMove(result, false);
+            if (result != MOVE_ILLEGAL && engineToMove()) {
+                playEngineMove();
+            }
+            outstanding.fetch_sub(1, memory_order_release);
+            continue;
+        }
+
+        if (analysis && !game.isOver() && game.position().key() != analysedKey) {
+            analyse();
+            continue;
+        }
+
+        unique_lock<mutex> lock(wakeMutex);
+        wakeCv.wait(lock, [this] { return !jobs.empty(); });
+    }
+}
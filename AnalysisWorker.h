@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include "Book.h"
+#include "Game.h"
+#include "SearchPool.h"
+#include "SpscQueue.h"
+#include "Uci.h"
+
+enum AnalysisJobType : uint8_t {
+    JOB_MOVE,
+    JOB_QUIT
+};
+
+struct AnalysisJob {
+    AnalysisJobType type;
+    uint8_t from;
+    uint8_t to;
+    uint8_t promo;
+};
+
+enum AnalysisResultType : uint8_t {
+    RESULT_MOVE,  // game after a move, with its legal moves and state worked out
+    RESULT_INFO   // one engine info line
+};
+
+// RESULT_MOVE carries a fixed-size snapshot of the game, no heap copies
+// through the queue; Game::load(game, legal) restores it on the UI thread
+struct AnalysisResult {
+    AnalysisResultType type;
+    bool byEngine;      // RESULT_MOVE: the computer's move, not one submitted
+    MoveResult result;
+    PackedGame game;
+    MoveList legal;
+    std::string line;
+};
+
+// the rules and the engine on their own thread, so the window never waits
+// for them. The worker owns the authoritative Game: every submitted move is
+// answered with the new game (legal moves for the hints, check, mate and
+// scores already worked out), the computer's replies are taken from the
+// opening book or searched and posted the same way, and with analysis on, the position is searched
+// while the user thinks. Jobs and results travel through lock-free SPSC
+// queues; the mutex and condition variable only put an idle worker to sleep.
+class AnalysisWorker {
+public:
+    // computerSide: colour the engine plays, or -1 for none
+    AnalysisWorker(const Game& start, const EngineOptions& opts, const SearchLimits& limits,
+                   int computerSide, bool analysis);
+    ~AnalysisWorker();
+
+    // UI thread only
+    void submitMove(Square from, Square to, PieceType promo);
+    bool poll(AnalysisResult& r) { return results.pop(r); }
+
+    // a result is still to come (move in flight, computer thinking,
+    // analysis running); read it before poll() so no result is missed
+    bool busy() const;
+
+private:
+    void run();
+    void submit(const AnalysisJob& job);
+    void post(const AnalysisResult& r);
+    void postMove(MoveResult result, bool byEngine);
+    void postInfo(const SearchInfo& info);
+    bool engineToMove() const;
+    void playEngineMove();
+    void analyse();
+
+    SpscQueue<AnalysisJob, 64> jobs;
+    SpscQueue<AnalysisResult, 64> results;
+    std::mutex wakeMutex;
+    std::condition_variable wakeCv;
+    std::atomic<int> outstanding;  // moves submitted or due from the engine
+    std::atomic<bool> analysing;
+
+    Game game;
+    TranspositionTable tt;
+    SearchPool engine;
+    OpeningBook book;
+    std::mt19937_64 rng;  // book move choice
+    SearchLimits limits;
+    int computerSide;
+    bool analysis;
+    uint64_t analysedKey;  // don't analyse a finished position again
+
+    std::thread thread;  // last, starts once everything above is built
+};
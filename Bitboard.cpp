@@ -0,0 +1,166 @@
+#include "Bitboard.h"
+
+using namespace std;
+
+Magic RookMagics[64];
+Magic BishopMagics[64];
+Bitboard PawnAttacks[COLOR_NB][64];
+Bitboard KnightAttacks[64];
+Bitboard KingAttacks[64];
+Bitboard BetweenBB[64][64];
+Bitboard LineBB[64][64];
+
+// shared storage for all slider lookups (fancy magics, one slice per square)
+static Bitboard RookTable[0x19000];
+static Bitboard BishopTable[0x1480];
+
+namespace {
+
+const int RookDirs[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+const int BishopDirs[4][2] = { { 1, 1 }, { 1, -1 }, { -1, 1 }, { -1, -1 } };
+
+// xorshift64* generator, fixed seeds keep startup deterministic
+struct PRNG {
+    uint64_t s;
+    explicit PRNG(uint64_t seed) : s(seed) {}
+    uint64_t rand() {
+        s ^= s >> 12; s ^= s << 25; s ^= s >> 27;
+        return s * 2685821657736338717ULL;
+    }
+    // few bits set, good magic candidates
+    uint64_t sparseRand() { return rand() & rand() & rand(); }
+};
+
+bool onBoard(int file, int rank) {
+    return file >= 0 && file < 8 && rank >= 0 && rank < 8;
+}
+
+// slow ray walk, only used to fill the tables
+Bitboard slidingAttack(const int dirs[4][2], Square s, Bitboard occupied) {
+    Bitboard attacks = 0;
+    for (int d = 0; d < 4; d++) {
+        int f = fileOf(s) + dirs[d][0];
+        int r = rankOf(s) + dirs[d][1];
+        while (onBoard(f, r)) {
+            Square t = makeSquare(f, r);
+            attacks |= squareBB(t);
+            if (occupied & squareBB(t)) {
+                break; // blocked
+            }
+            f += dirs[d][0];
+            r += dirs[d][1];
+        }
+    }
+    return attacks;
+}
+
+Bitboard stepAttack(const int steps[][2], int count, Square s) {
+    Bitboard b = 0;
+    for (int i = 0; i < count; i++) {
+        int f = fileOf(s) + steps[i][0];
+        int r = rankOf(s) + steps[i][1];
+        if (onBoard(f, r)) {
+            b |= squareBB(makeSquare(f, r));
+        }
+    }
+    return b;
+}
+
+void initMagics(const int dirs[4][2], Bitboard table[], Magic magics[]) {
+#if !defined(USE_PEXT)
+    // seeds per rank known to find magics quickly
+    const uint64_t seeds[8] = { 728, 10316, 55013, 32803, 12281, 15100, 16645, 255 };
+    Bitboard occupancy[4096];
+    int epoch[4096] = {}, cnt = 0;
+#endif
+    Bitboard reference[4096];
+    Bitboard* next = table;
+
+    for (Square s = 0; s < 64; s++) {
+        // board edges are not part of the relevant occupancy
+        Bitboard edges = ((0xFFULL | 0xFF00000000000000ULL) & ~(0xFFULL << (8 * rankOf(s))))
+                       | ((0x0101010101010101ULL | 0x8080808080808080ULL) & ~(0x0101010101010101ULL << fileOf(s)));
+
+        Magic& m = magics[s];
+        m.mask = slidingAttack(dirs, s, 0) & ~edges;
+        m.shift = 64 - popcount(m.mask);
+        m.attacks = next;
+
+        // enumerate all subsets of the mask (carry-rippler)
+        int size = 0;
+        Bitboard b = 0;
+        do {
+            reference[size] = slidingAttack(dirs, s, b);
+#if defined(USE_PEXT)
+            m.attacks[_pext_u64(b, m.mask)] = reference[size];
+#else
+            occupancy[size] = b;
+#endif
+            size++;
+            b = (b - m.mask) & m.mask;
+        } while (b);
+        next += size;
+
+#if !defined(USE_PEXT)
+        // search a magic that maps every subset to a consistent slot
+        PRNG rng(seeds[rankOf(s)]);
+        for (int i = 0; i < size; ) {
+            for (m.magic = 0; popcount((m.magic * m.mask) >> 56) < 6; ) {
+                m.magic = rng.sparseRand();
+            }
+            for (++cnt, i = 0; i < size; i++) {
+                unsigned idx = m.index(occupancy[i]);
+                if (epoch[idx] < cnt) {
+                    epoch[idx] = cnt;
+                    m.attacks[idx] = reference[i];
+                }
+                else if (m.attacks[idx] != reference[i]) {
+                    break;
+                }
+            }
+        }
+#endif
+    }
+}
+
+} // namespace
+
+void initBitboards() {
+    static bool done = false;
+    if (done) {
+        return;
+    }
+    done = true;
+
+    const int knightSteps[8][2] = { { 1, 2 }, { 2, 1 }, { 2, -1 }, { 1, -2 }, { -1, -2 }, { -2, -1 }, { -2, 1 }, { -1, 2 } };
+    const int kingSteps[8][2] = { { 1, 0 }, { 1, 1 }, { 0, 1 }, { -1, 1 }, { -1, 0 }, { -1, -1 }, { 0, -1 }, { 1, -1 } };
+    const int whitePawnSteps[2][2] = { { -1, 1 }, { 1, 1 } };
+    const int blackPawnSteps[2][2] = { { -1, -1 }, { 1, -1 } };
+
+    for (Square s = 0; s < 64; s++) {
+        KnightAttacks[s] = stepAttack(knightSteps, 8, s);
+        KingAttacks[s] = stepAttack(kingSteps, 8, s);
+        PawnAttacks[WHITE][s] = stepAttack(whitePawnSteps, 2, s);
+        PawnAttacks[BLACK][s] = stepAttack(blackPawnSteps, 2, s);
+    }
+
+    initMagics(RookDirs, RookTable, RookMagics);
+    initMagics(BishopDirs, BishopTable, BishopMagics);
+
+    for (Square a = 0; a < 64; a++) {
+        for (Square b = 0; b < 64; b++) {
+            BetweenBB[a][b] = LineBB[a][b] = 0;
+            if (a == b) {
+                continue;
+            }
+            if (bishopAttacks(a, 0) & squareBB(b)) {
+                LineBB[a][b] = (bishopAttacks(a, 0) & bishopAttacks(b, 0)) | squareBB(a) | squareBB(b);
+                BetweenBB[a][b] = bishopAttacks(a, squareBB(b)) & bishopAttacks(b, squareBB(a));
+            }
+            else if (rookAttacks(a, 0) & squareBB(b)) {
+                LineBB[a][b] = (rookAttacks(a, 0) & rookAttacks(b, 0)) | squareBB(a) | squareBB(b);
+                BetweenBB[a][b] = rookAttacks(a, squareBB(b)) & rookAttacks(b, squareBB(a));
+            }
+        }
+    }
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// pext indexing is used for slider lookups when the compiler targets BMI2,
+// otherwise the portable magic multiply is used
+#if defined(__BMI2__) && !defined(NO_PEXT)
+#include <immintrin.h>
+#define USE_PEXT
+#endif
+
+// BASIC TYPES
+// squares are numbered a1 = 0, b1 = 1 ... h8 = 63
+typedef uint64_t Bitboard;
+typedef int Square;
+
+const Square NO_SQUARE = 64;
+
+enum Color { WHITE, BLACK, COLOR_NB };
+enum PieceType { PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING, PIECE_TYPE_NB };
+enum Piece {
+    W_PAWN, W_KNIGHT, W_BISHOP, W_ROOK, W_QUEEN, W_KING,
+    B_PAWN, B_KNIGHT, B_BISHOP, B_ROOK, B_QUEEN, B_KING,
+    PIECE_NB, NO_PIECE = PIECE_NB
+};
+
+inline Color operator~(Color c) { return Color(c ^ 1); }
+
+inline Piece makePiece(Color c, PieceType pt) { return Piece(c * 6 + pt); }
+inline Color colorOf(Piece pc) { return Color(pc >= B_PAWN); }
+inline PieceType typeOf(Piece pc) { return PieceType(pc % 6); }
+
+// SQUARE HELPERS
+inline int fileOf(Square s) { return s & 7; }
+inline int rankOf(Square s) { return s >> 3; }
+inline Square makeSquare(int file, int rank) { return rank * 8 + file; }
+
+// the SFML board uses row 0 = rank 8 and col 0 = file a
+inline Square squareAt(int row, int col) { return (7 - row) * 8 + col; }
+inline int rowOf(Square s) { return 7 - rankOf(s); }
+inline int colOf(Square s) { return fileOf(s); }
+
+inline Bitboard squareBB(Square s) { return 1ULL << s; }
+
+// FILE AND RANK MASKS
+const Bitboard FileABB = 0x0101010101010101ULL;
+const Bitboard FileHBB = FileABB << 7;
+const Bitboard Rank1BB = 0xFFULL;
+
+inline Bitboard fileBB(int f) { return FileABB << f; }
+inline Bitboard rankBB(int r) { return Rank1BB << (8 * r); }
+
+inline Bitboard adjacentFilesBB(int f) {
+    return (f > 0 ? fileBB(f - 1) : 0) | (f < 7 ? fileBB(f + 1) : 0);
+}
+
+// rank of s counted from c's own back rank
+inline int relativeRank(Color c, Square s) { return c == WHITE ? rankOf(s) : 7 - rankOf(s); }
+
+// all squares on ranks strictly in front of s from c's point of view
+inline Bitboard forwardRanksBB(Color c, Square s) {
+    int r = rankOf(s);
+    if (c == WHITE) {
+        return r == 7 ? 0 : ~0ULL << (8 * (r + 1));
+    }
+    return r == 0 ? 0 : ~0ULL >> (8 * (8 - r));
+}
+
+// squares attacked by a set of pawns of colour c
+inline Bitboard pawnAttacksBB(Color c, Bitboard pawns) {
+    return c == WHITE ? ((pawns & ~FileABB) << 7) | ((pawns & ~FileHBB) << 9)
+                      : ((pawns & ~FileABB) >> 9) | ((pawns & ~FileHBB) >> 7);
+}
+
+// BIT TRICKS
+inline int popcount(Bitboard b) {
+#if defined(_MSC_VER)
+    return (int)__popcnt64(b);
+#else
+    return __builtin_popcountll(b);
+#endif
+}
+
+// index of the lowest set bit, b must not be empty
+inline Square lsb(Bitboard b) {
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanForward64(&idx, b);
+    return (Square)idx;
+#else
+    return __builtin_ctzll(b);
+#endif
+}
+
+inline Square popLsb(Bitboard& b) {
+    Square s = lsb(b);
+    b &= b - 1;
+    return s;
+}
+
+inline bool moreThanOne(Bitboard b) { return (b & (b - 1)) != 0; }
+
+// ATTACK TABLES
+// built once by initBitboards(), must be called at startup
+
+struct Magic {
+    Bitboard mask;
+    Bitboard magic;
+    Bitboard* attacks;
+    unsigned shift;
+
+    unsigned index(Bitboard occupied) const {
+#if defined(USE_PEXT)
+        return (unsigned)_pext_u64(occupied, mask);
+#else
+        return (unsigned)(((occupied & mask) * magic) >> shift);
+#endif
+    }
+};
+
+extern Magic RookMagics[64];
+extern Magic BishopMagics[64];
+extern Bitboard PawnAttacks[COLOR_NB][64];
+extern Bitboard KnightAttacks[64];
+extern Bitboard KingAttacks[64];
+extern Bitboard BetweenBB[64][64];
+extern Bitboard LineBB[64][64];
+
+void initBitboards();
+
+inline Bitboard rookAttacks(Square s, Bitboard occupied) {
+    const Magic& m = RookMagics[s];
+    return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard bishopAttacks(Square s, Bitboard occupied) {
+    const Magic& m = BishopMagics[s];
+    return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard queenAttacks(Square s, Bitboard occupied) {
+    return rookAttacks(s, occupied) | bishopAttacks(s, occupied);
+}
+
+// attacks of a non-pawn piece type from s, pawns use PawnAttacks
+inline Bitboard attacksBB(PieceType pt, Square s, Bitboard occupied) {
+    switch (pt) {
+    case KNIGHT: return KnightAttacks[s];
+    case BISHOP: return bishopAttacks(s, occupied);
+    case ROOK: return rookAttacks(s, occupied);
+    case QUEEN: return queenAttacks(s, occupied);
+    case KING: return KingAttacks[s];
+    default: return 0;
+    }
+}
+
+// squares strictly between a and b if they share a line, else 0
+inline Bitboard betweenBB(Square a, Square b) { return BetweenBB[a][b]; }
+
+// whole board line through a and b if they share one, else 0
+inline Bitboard lineBB(Square a, Square b) { return LineBB[a][b]; }
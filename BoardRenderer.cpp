@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <iostream>
+#include "BoardRenderer.h"
+
+using namespace std;
+
+// file names of the piece images, in Piece order
+static const char* const PieceFiles[PIECE_NB] = {
+    "wP.png", "wN.png", "wB.png", "wR.png", "wQ.png", "wK.png",
+    "bP.png", "bN.png", "bB.png", "bR.png", "bQ.png", "bK.png"
+};
+
+BoardRenderer::BoardRenderer(float squareSize)
+    : size(squareSize), squares(sf::Quads, 64 * 4), layerValid(false), highlights(sf::Quads), pieces(sf::Quads),
+      shownKey(0), shownHidden(NO_SQUARE), piecesValid(false) {
+    for (int r = 0; r < 8; ++r) {
+        for (int c = 0; c < 8; ++c) {
+            sf::Color color = (r + c) % 2 == 0
+                ? sf::Color(230, 235, 240)  // light blue
+                : sf::Color(60, 90, 140);   // dark blue
+            setQuad(&squares[(r * 8 + c) * 4], sf::Vector2f(c * size, r * size), color);
+        }
+    }
+}
+
+bool BoardRenderer::loadPieces(const string& dir) {
+    // 6 x 2 grid of equal cells, as big as the largest image
+    sf::Image images[PIECE_NB];
+    unsigned cellW = 1, cellH = 1;
+    bool ok = true;
+    for (int pc = 0; pc < PIECE_NB; pc++) {
+        if (!images[pc].loadFromFile(dir + PieceFiles[pc])) {
+            cout << "error loading " << PieceFiles[pc] << endl;
+            ok = false;
+            continue;
+        }
+        cellW = max(cellW, images[pc].getSize().x);
+        cellH = max(cellH, images[pc].getSize().y);
+    }
+
+    sf::Image sheet;
+    sheet.create(cellW * 6, cellH * 2, sf::Color::Transparent);
+    for (int pc = 0; pc < PIECE_NB; pc++) {
+        unsigned x = (pc % 6) * cellW, y = (pc / 6) * cellH;
+        sf::Vector2u sz = images[pc].getSize();
+        sheet.copy(images[pc], x, y);
+        pieceRect[pc] = sf::IntRect(x, y, sz.x, sz.y);
+    }
+    atlas.loadFromImage(sheet);
+    piecesValid = false;
+    return ok;
+}
+
+void BoardRenderer::setQuad(sf::Vertex* quad, sf::Vector2f p, sf::Color color) const {
+    quad[0] = sf::Vertex(p, color);
+    quad[1] = sf::Vertex(sf::Vector2f(p.x + size, p.y), color);
+    quad[2] = sf::Vertex(sf::Vector2f(p.x + size, p.y + size), color);
+    quad[3] = sf::Vertex(sf::Vector2f(p.x, p.y + size), color);
+}
+
+void BoardRenderer::setPieceQuad(sf::Vertex* quad, Piece pc, sf::Vector2f p) const {
+    const sf::IntRect& r = pieceRect[pc];
+    float left = r.left, top = r.top, right = r.left + r.width, bottom = r.top + r.height;
+    quad[0] = sf::Vertex(p, sf::Vector2f(left, top));
+    quad[1] = sf::Vertex(sf::Vector2f(p.x + size, p.y), sf::Vector2f(right, top));
+    quad[2] = sf::Vertex(sf::Vector2f(p.x + size, p.y + size), sf::Vector2f(right, bottom));
+    quad[3] = sf::Vertex(sf::Vector2f(p.x, p.y + size), sf::Vector2f(left, bottom));
+}
+
+void BoardRenderer::setPosition(const Position& pos, Square hidden) {
+    if (piecesValid && pos.key() == shownKey && hidden == shownHidden) {
+        return;
+    }
+    shownKey = pos.key();
+    shownHidden = hidden;
+    piecesValid = true;
+
+    Bitboard occ = pos.pieces();
+    if (hidden != NO_SQUARE) {
+        occ &= ~squareBB(hidden);
+    }
+    pieces.resize(popcount(occ) * 4);
+    size_t i = 0;
+    while (occ) {
+        Square s = popLsb(occ);
+        setPieceQuad(&pieces[i], pos.pieceOn(s), sf::Vector2f(colOf(s) * size, rowOf(s) * size));
+        i += 4;
+    }
+}
+
+void BoardRenderer::setHighlights(const vector<Highlight>& marks) {
+    highlights.resize(marks.size() * 4);
+    for (size_t i = 0; i < marks.size(); i++) {
+        Square s = marks[i].sq;
+        setQuad(&highlights[i * 4], sf::Vector2f(colOf(s) * size, rowOf(s) * size), marks[i].color);
+    }
+}
+
+void BoardRenderer::buildBoardLayer(const sf::Font* font) {
+    labels.clear();
+    if (font) {
+        sf::Text text;
+        text.setFont(*font);
+        text.setCharacterSize(20);
+        text.setFillColor(sf::Color::Black);
+        for (int i = 0; i < 8; i++) {
+            // 1-8 left, centred in the square's height
+            text.setString(to_string(8 - i));
+            text.setPosition(5, i * size + size / 2 - 10);
+            labels.push_back(text);
+            // a-h in the bottom left corner of the last row
+            text.setString(string(1, char('a' + i)));
+            text.setPosition(i * size + 5, 8 * size - 25);
+            labels.push_back(text);
+        }
+    }
+
+    // without render texture support the layer is drawn piece by piece
+    layerValid = boardLayer.create((unsigned)(8 * size), (unsigned)(8 * size));
+    if (layerValid) {
+        boardLayer.clear();
+        boardLayer.draw(squares);
+        for (const sf::Text& t : labels) {
+            boardLayer.draw(t);
+        }
+        boardLayer.display();
+    }
+}
+
+void BoardRenderer::drawBoard(sf::RenderTarget& target) const {
+    if (layerValid) {
+        target.draw(sf::Sprite(boardLayer.getTexture()));
+        return;
+    }
+    target.draw(squares);
+    for (const sf::Text& t : labels) {
+        target.draw(t);
+    }
+}
+
+void BoardRenderer::drawHighlights(sf::RenderTarget& target) const {
+    if (highlights.getVertexCount()) {
+        target.draw(highlights);
+    }
+}
+
+void BoardRenderer::drawPieces(sf::RenderTarget& target) const {
+    if (pieces.getVertexCount()) {
+        target.draw(pieces, &atlas);
+    }
+}
+
+void BoardRenderer::drawPiece(sf::RenderTarget& target, Piece pc, sf::Vector2f topLeft) const {
+    sf::Vertex quad[4];
+    setPieceQuad(quad, pc, topLeft);
+    target.draw(quad, 4, sf::Quads, &atlas);
+}
+
+void BoardRenderer::drawPieceRow(sf::RenderTarget& target, const Piece* pcs, int n, sf::Vector2f topLeft) const {
+    vector<sf::Vertex> quads(n * 4);
+    for (int i = 0; i < n; i++) {
+        setPieceQuad(&quads[i * 4], pcs[i], sf::Vector2f(topLeft.x + i * size, topLeft.y));
+    }
+    target.draw(quads.data(), quads.size(), sf::Quads, &atlas);
+}
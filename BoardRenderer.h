@@ -0,0 +1,63 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+#include "Position.h"
+
+// a coloured square drawn over the board (selection, move hints)
+struct Highlight {
+    Square sq;
+    sf::Color color;
+};
+
+// draws the board in a few draw calls. The 12 piece images are packed into
+// one atlas texture at load time; squares, highlights and pieces are vertex
+// arrays (one quad per square / highlight / piece) that are only rebuilt
+// when what they show changes.
+class BoardRenderer {
+public:
+    explicit BoardRenderer(float squareSize);
+
+    // loads wP.png ... bK.png from dir into the atlas, false if any is missing
+    bool loadPieces(const std::string& dir = "");
+
+    // pieces of pos, except the one on hidden (the piece being dragged);
+    // cheap when neither changed since the last call
+    void setPosition(const Position& pos, Square hidden = NO_SQUARE);
+    void setHighlights(const std::vector<Highlight>& marks);
+
+    // squares plus coordinate labels (no labels without a font), rendered
+    // once into a texture so a frame draws the static board as one sprite;
+    // call again if the font changes
+    void buildBoardLayer(const sf::Font* font);
+
+    void drawBoard(sf::RenderTarget& target) const;
+    void drawHighlights(sf::RenderTarget& target) const;
+    void drawPieces(sf::RenderTarget& target) const;
+
+    // one piece anywhere (the dragged piece), topLeft in
+    // board coordinates
+    void drawPiece(sf::RenderTarget& target, Piece pc, sf::Vector2f topLeft) const;
+
+    // n pieces side by side from topLeft in one draw call (promotion menu)
+    void drawPieceRow(sf::RenderTarget& target, const Piece* pcs, int n, sf::Vector2f topLeft) const;
+
+private:
+    void setQuad(sf::Vertex* quad, sf::Vector2f topLeft, sf::Color color) const;
+    void setPieceQuad(sf::Vertex* quad, Piece pc, sf::Vector2f topLeft) const;
+
+    float size;
+    sf::Texture atlas;
+    sf::IntRect pieceRect[PIECE_NB];  // where each piece sits in the atlas
+
+    sf::VertexArray squares;     // built once
+    std::vector<sf::Text> labels;
+    sf::RenderTexture boardLayer;  // squares + labels, see buildBoardLayer()
+    bool layerValid;
+    sf::VertexArray highlights;
+    sf::VertexArray pieces;
+    uint64_t shownKey;           // position the pieces array shows
+    Square shownHidden;
+    bool piecesValid;
+};
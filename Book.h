@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+#include "Position.h"
+
+// POLYGLOT OPENING BOOK
+// A .bin book is a sorted array of 16-byte big-endian entries: position
+// key, move, weight, learn. The key is Polyglot's own Zobrist hash, built
+// from a table of 781 random numbers (pieces, castling, en passant, side).
+// The built-in table is the one published with Polyglot, so books made by
+// other programs probe as they are; loadPolyglotRandoms() replaces it with
+// a table from a text file.
+
+struct BookMove {
+    Move move;
+    int weight;
+};
+
+// replaces the built-in table with 781 hex numbers separated by white
+// space or commas, in Polyglot order
+bool loadPolyglotRandoms(const std::string& path);
+
+uint64_t polyglotKey(const Position& pos);
+
+// Polyglot move code (castling as king takes own rook) <-> our moves
+uint16_t toPolyglotMove(Move m);
+Move fromPolyglotMove(Position& pos, uint16_t pm);
+
+class OpeningBook {
+public:
+    // maps the book, false if missing or not a multiple of 16 bytes
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return count > 0; }
+    uint64_t entries() const { return count; }
+
+    // legal book moves for pos, best weight first; empty when out of book
+    void probe(Position& pos, std::vector<BookMove>& moves) const;
+
+    // a book move picked with probability proportional to its weight,
+    // random is any uniformly random number; MOVE_NONE when out of book
+    Move pick(Position& pos, uint64_t random) const;
+
+private:
+    MappedFile map;
+    const unsigned char* data = nullptr;
+    uint64_t count = 0;
+};
+
+struct BookBuildOptions {
+    int maxPly = 24;     // only positions before this ply
+    int minGames = 3;    // drop moves played in fewer games
+    int threads = 0;     // PGN parsing threads, 0 = all cores
+};
+
+// builds a book from PGN files: every move of the side that scored counts
+// 2 for a win and 1 for a draw; a position's weights are scaled to fit in
+// 16 bits. Returns the number of entries written, -1 on error.
+int64_t buildBook(const std::vector<std::string>& pgnFiles, const std::string& out, const BookBuildOptions& opts);
@@ -0,0 +1,117 @@
+// headless opening book tool: builds a Polyglot book from PGN files and
+// shows the book moves of a position
+//
+// usage: book build <out.bin> <file.pgn>... [--plies N] [--min-games N] [--threads N] [--keys file]
+//        book probe <in.bin> [--fen "<fen>"] [--moves "e4 e5 Nf3"] [--keys file]
+//   --plies N       only book the first N plies of every game (default 24)
+//   --min-games N   drop moves played in fewer than N games (default 3)
+//   --threads N     PGN parsing threads (0 = all cores)
+//   --keys file     Polyglot random table to use instead of the built-in one
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Book.h"
+#include "MoveGen.h"
+
+using namespace std;
+
+static void usage() {
+    cout << "usage: book build <out.bin> <file.pgn>... [--plies N] [--min-games N] [--threads N] [--keys file]" << endl;
+    cout << "       book probe <in.bin> [--fen \"<fen>\"] [--moves \"e4 e5 Nf3\"] [--keys file]" << endl;
+}
+
+static double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    initBitboards();
+    if (argc < 3) {
+        usage();
+        return 1;
+    }
+    string command = argv[1];
+    string bookPath = argv[2];
+    vector<string> pgnFiles;
+    string fen = StartFEN;
+    string moves;
+    string keys;
+    BookBuildOptions opts;
+    for (int i = 3; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--plies" && i + 1 < argc) { opts.maxPly = atoi(argv[++i]); }
+        else if (arg == "--min-games" && i + 1 < argc) { opts.minGames = atoi(argv[++i]); }
+        else if (arg == "--threads" && i + 1 < argc) { opts.threads = atoi(argv[++i]); }
+        else if (arg == "--fen" && i + 1 < argc) { fen = argv[++i]; }
+        else if (arg == "--moves" && i + 1 < argc) { moves = argv[++i]; }
+        else if (arg == "--keys" && i + 1 < argc) { keys = argv[++i]; }
+        else { pgnFiles.push_back(arg); }
+    }
+    if (!keys.empty() && !loadPolyglotRandoms(keys)) {
+        cout << "can't read 781 keys from " << keys << endl;
+        return 1;
+    }
+
+    if (command == "build") {
+        if (pgnFiles.empty()) {
+            usage();
+            return 1;
+        }
+        auto start = chrono::steady_clock::now();
+        int64_t entries = buildBook(pgnFiles, bookPath, opts);
+        if (entries < 0) {
+            cout << "book build failed" << endl;
+            return 1;
+        }
+        cout << "wrote " << entries << " entries to " << bookPath << " in " << secondsSince(start) << " s" << endl;
+        return 0;
+    }
+    if (command != "probe") {
+        usage();
+        return 1;
+    }
+
+    OpeningBook book;
+    if (!book.open(bookPath)) {
+        cout << "can't open book " << bookPath << endl;
+        return 1;
+    }
+    Position pos;
+    if (!pos.setFen(fen)) {
+        cout << "invalid fen: " << fen << endl;
+        return 1;
+    }
+    istringstream ss(moves);
+    string san;
+    while (ss >> san) {
+        Move m = parseSan(pos, san.c_str(), san.size());
+        if (m == MOVE_NONE) {
+            cout << "illegal move: " << san << endl;
+            return 1;
+        }
+        pos.makeMove(m);
+    }
+
+    vector<BookMove> found;
+    auto start = chrono::steady_clock::now();
+    book.probe(pos, found);
+    double us = secondsSince(start) * 1e6;
+    int total = 0;
+    for (const BookMove& bm : found) {
+        total += bm.weight;
+    }
+    for (const BookMove& bm : found) {
+        cout << moveToSan(pos, bm.move) << "\t" << bm.weight << "\t"
+             << (total ? 100.0 * bm.weight / total : 0.0) << "%" << endl;
+    }
+    if (found.empty()) {
+        cout << "out of book" << endl;
+    }
+    cout << "key " << hex << polyglotKey(pos) << dec << ", " << book.entries() << " entries, lookup " << us << " us"
+         << endl;
+    return 0;
+}
@@ -0,0 +1,220 @@
+#include <algorithm>
+#include "Evaluate.h"
+#include "Pawns.h"
+
+using namespace std;
+
+namespace {
+
+// middlegame / endgame pair, the two halves of every term
+struct EvalScore {
+    int mg = 0;
+    int eg = 0;
+
+    void add(int m, int e) { mg += m; eg += e; }
+    void sub(const EvalScore& o) { mg -= o.mg; eg -= o.eg; }
+};
+
+const int PieceValueMg[PIECE_TYPE_NB] = { 100, 320, 330, 500, 900, 0 };
+const int PieceValueEg[PIECE_TYPE_NB] = { 120, 300, 320, 520, 900, 0 };
+
+// piece-square tables from white's side, written as the board is seen:
+// first row is rank 8, so a white piece on s uses entry s ^ 56
+const int PawnMg[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+     50,  50,  50,  50,  50,  50,  50,  50,
+     10,  10,  20,  30,  30,  20,  10,  10,
+      5,   5,  10,  25,  25,  10,   5,   5,
+      0,   0,   0,  20,  20,   0,   0,   0,
+      5,  -5, -10,   0,   0, -10,  -5,   5,
+      5,  10,  10, -20, -20,  10,  10,   5,
+      0,   0,   0,   0,   0,   0,   0,   0
+};
+
+const int PawnEg[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+     40,  40,  40,  40,  40,  40,  40,  40,
+     30,  30,  30,  30,  30,  30,  30,  30,
+     20,  20,  20,  20,  20,  20,  20,  20,
+     10,  10,  10,  10,  10,  10,  10,  10,
+      5,   5,   5,   5,   5,   5,   5,   5,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0
+};
+
+const int KnightPsq[64] = {
+    -50, -40, -30, -30, -30, -30, -40, -50,
+    -40, -20,   0,   0,   0,   0, -20, -40,
+    -30,   0,  10,  15,  15,  10,   0, -30,
+    -30,   5,  15,  20,  20,  15,   5, -30,
+    -30,   0,  15,  20,  20,  15,   0, -30,
+    -30,   5,  10,  15,  15,  10,   5, -30,
+    -40, -20,   0,   5,   5,   0, -20, -40,
+    -50, -40, -30, -30, -30, -30, -40, -50
+};
+
+const int BishopPsq[64] = {
+    -20, -10, -10, -10, -10, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,  10,  10,   5,   0, -10,
+    -10,   5,   5,  10,  10,   5,   5, -10,
+    -10,   0,  10,  10,  10,  10,   0, -10,
+    -10,  10,  10,  10,  10,  10,  10, -10,
+    -10,   5,   0,   0,   0,   0,   5, -10,
+    -20, -10, -10, -10, -10, -10, -10, -20
+};
+
+const int RookPsq[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+      5,  10,  10,  10,  10,  10,  10,   5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+      0,   0,   0,   5,   5,   0,   0,   0
+};
+
+const int QueenPsq[64] = {
+    -20, -10, -10,  -5,  -5, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,   5,   5,   5,   0, -10,
+     -5,   0,   5,   5,   5,   5,   0,  -5,
+      0,   0,   5,   5,   5,   5,   0,  -5,
+    -10,   5,   5,   5,   5,   5,   0, -10,
+    -10,   0,   5,   0,   0,   0,   0, -10,
+    -20, -10, -10,  -5,  -5, -10, -10, -20
+};
+
+// castled and sheltered in the middlegame, central in the endgame
+const int KingMg[64] = {
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -20, -30, -30, -40, -40, -30, -30, -20,
+    -10, -20, -20, -20, -20, -20, -20, -10,
+     20,  20,   0,   0,   0,   0,  20,  20,
+     20,  30,  10,   0,   0,  10,  30,  20
+};
+
+const int KingEg[64] = {
+    -50, -40, -30, -20, -20, -30, -40, -50,
+    -30, -20, -10,   0,   0, -10, -20, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -30,   0,   0,   0,   0, -30, -30,
+    -50, -30, -30, -30, -30, -30, -30, -50
+};
+
+const int* const TableMg[PIECE_TYPE_NB] = { PawnMg, KnightPsq, BishopPsq, RookPsq, QueenPsq, KingMg };
+const int* const TableEg[PIECE_TYPE_NB] = { PawnEg, KnightPsq, BishopPsq, RookPsq, QueenPsq, KingEg };
+
+// mobility: bonus per reachable square around a typical count
+const int MobilityCenter[PIECE_TYPE_NB] = { 0, 4, 6, 7, 13, 0 };
+const int MobilityMg[PIECE_TYPE_NB] = { 0, 4, 5, 2, 1, 0 };
+const int MobilityEg[PIECE_TYPE_NB] = { 0, 4, 5, 4, 2, 0 };
+
+// king safety: units per king-zone square attacked, by attacker type
+const int KingAttackUnits[PIECE_TYPE_NB] = { 0, 2, 2, 3, 5, 0 };
+
+const int BishopPairMg = 30, BishopPairEg = 50;
+const int Tempo = 10;
+
+// mobility of c's pieces, and the attack units they put on the enemy king
+EvalScore evalPieces(const Position& pos, Color c) {
+    EvalScore sc;
+    Bitboard occ = pos.pieces();
+    Bitboard safe = ~pos.pieces(c) & ~pawnAttacksBB(~c, pos.pieces(~c, PAWN));
+    Square theirKing = pos.kingSquare(~c);
+    Bitboard kingZone = KingAttacks[theirKing] | squareBB(theirKing);
+
+    int attackers = 0;
+    int units = 0;
+    for (int pt = KNIGHT; pt <= QUEEN; pt++) {
+        Bitboard b = pos.pieces(c, PieceType(pt));
+        while (b) {
+            Square s = popLsb(b);
+            Bitboard att = attacksBB(PieceType(pt), s, occ);
+            int mob = popcount(att & safe) - MobilityCenter[pt];
+            sc.add(MobilityMg[pt] * mob, MobilityEg[pt] * mob);
+
+            Bitboard zoneHits = att & kingZone;
+            if (zoneHits) {
+                attackers++;
+                units += KingAttackUnits[pt] * popcount(zoneHits);
+            }
+        }
+    }
+
+    // a lone attacker is rarely dangerous, several grow quadratically
+    if (attackers >= 2) {
+        sc.add(min(units * units, 500), 0);
+    }
+    return sc;
+}
+
+} // namespace
+
+int PsqMg[PIECE_NB][64];
+int PsqEg[PIECE_NB][64];
+
+// fill the tables before main() runs; black uses the vertically mirrored
+// square and the negated value
+static struct PsqInit {
+    PsqInit() {
+        for (int pt = PAWN; pt <= KING; pt++) {
+            for (Square s = 0; s < 64; s++) {
+                int mg = PieceValueMg[pt] + TableMg[pt][s ^ 56];
+                int eg = PieceValueEg[pt] + TableEg[pt][s ^ 56];
+                PsqMg[makePiece(WHITE, PieceType(pt))][s] = mg;
+                PsqEg[makePiece(WHITE, PieceType(pt))][s] = eg;
+                PsqMg[makePiece(BLACK, PieceType(pt))][s ^ 56] = -mg;
+                PsqEg[makePiece(BLACK, PieceType(pt))][s ^ 56] = -eg;
+            }
+        }
+    }
+} psqInit;
+
+// tapered: every term has a middlegame and an endgame value, blended by
+// the phase; material and piece-square sums come ready from the position
+int evaluate(const Position& pos, PawnTable* pawns) {
+    EvalScore sc;
+    sc.add(pos.psqMg(), pos.psqEg());
+
+    PawnEntry local;
+    const PawnEntry* pe = &local;
+    if (pawns) {
+        pe = &pawns->probe(pos);
+    }
+    else {
+        computePawnEntry(pos, local);
+    }
+    sc.add(pe->mg, pe->eg);
+
+    // pawn shield counts while the king is still on its back two ranks
+    for (int c = WHITE; c <= BLACK; c++) {
+        Square ksq = pos.kingSquare(Color(c));
+        if (relativeRank(Color(c), ksq) <= 1) {
+            int shield = pe->shield[c][fileOf(ksq)];
+            sc.add(c == WHITE ? shield : -shield, 0);
+        }
+    }
+
+    EvalScore w = evalPieces(pos, WHITE);
+    w.sub(evalPieces(pos, BLACK));
+    sc.add(w.mg, w.eg);
+
+    if (pos.count(W_BISHOP) >= 2) {
+        sc.add(BishopPairMg, BishopPairEg);
+    }
+    if (pos.count(B_BISHOP) >= 2) {
+        sc.add(-BishopPairMg, -BishopPairEg);
+    }
+
+    int phase = min(pos.phase(), PHASE_MAX);
+    int score = (sc.mg * phase + sc.eg * (PHASE_MAX - phase)) / PHASE_MAX;
+    return (pos.sideToMove() == WHITE ? score : -score) + Tempo;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Position.h"
+
+class PawnTable;
+
+const int PAWN_VALUE = 100;
+
+// game phase from the non-pawn material left: 24 = all pieces on the board
+// (middlegame), 0 = only kings and pawns (endgame)
+const int PHASE_MAX = 24;
+const int PhaseWeight[PIECE_TYPE_NB] = { 0, 1, 1, 2, 4, 0 };
+
+// material + piece-square value of a piece on a square, middlegame and
+// endgame, positive for white pieces and negative for black ones; the
+// position keeps their sums up to date as pieces move
+extern int PsqMg[PIECE_NB][64];
+extern int PsqEg[PIECE_NB][64];
+
+// static evaluation in centipawns from the side to move's point of view;
+// pawn terms come from the cache when one is given
+int evaluate(const Position& pos, PawnTable* pawns = nullptr);
@@ -0,0 +1,104 @@
+#include "Game.h"
+
+using namespace std;
+
+Game::Game() {
+    reset();
+}
+
+void Game::reset() {
+    setFen(StartFEN);
+}
+
+bool Game::setFen(const string& fen) {
+    bool ok = pos.setFen(fen);
+    if (!ok) {
+        pos.setStartPosition();
+    }
+    scores[WHITE] = scores[BLACK] = 0;
+    lastCapture = NO_PIECE;
+    loadedLastMove = MOVE_NONE;
+    refresh();
+    return ok;
+}
+
+void Game::save(PackedGame& pg) const {
+    pos.pack(pg.pos);
+    pg.scores[WHITE] = int16_t(scores[WHITE]);
+    pg.scores[BLACK] = int16_t(scores[BLACK]);
+    pg.state = uint8_t(state);
+    pg.lastCapture = uint8_t(lastCapture);
+    pg.lastMove = lastMove();
+}
+
+void Game::load(const PackedGame& pg) {
+    pos.unpack(pg.pos);
+    scores[WHITE] = pg.scores[WHITE];
+    scores[BLACK] = pg.scores[BLACK];
+    lastCapture = Piece(pg.lastCapture);
+    loadedLastMove = Move(pg.lastMove);
+    refresh();
+}
+
+void Game::load(const PackedGame& pg, const MoveList& legalMoves) {
+    pos.unpack(pg.pos);
+    scores[WHITE] = pg.scores[WHITE];
+    scores[BLACK] = pg.scores[BLACK];
+    lastCapture = Piece(pg.lastCapture);
+    loadedLastMove = Move(pg.lastMove);
+    legal = legalMoves;
+    state = GameStatus(pg.state);
+}
+
+Move Game::findMove(Square from, Square to, PieceType promo) const {
+    for (Move m : legal) {
+        if (fromSq(m) == from && toSq(m) == to
+            && (typeOfMove(m) != PROMOTION || promotionType(m) == promo)) {
+            return m;
+        }
+    }
+    return MOVE_NONE;
+}
+
+MoveResult Game::applyMove(Square from, Square to, PieceType promo) {
+    Move m = findMove(from, to, promo);
+    return m == MOVE_NONE ? MOVE_ILLEGAL : applyMove(m);
+}
+
+MoveResult Game::applyMove(Move m) {
+    if (isOver() || !legal.contains(m)) {
+        return MOVE_ILLEGAL;
+    }
+
+    Color us = pos.sideToMove();
+    lastCapture = pos.capturedBy(m);
+    scores[us] += getPieceValue(lastCapture);
+    pos.makeMove(m);
+    return refresh();
+}
+
+bool Game::isPromotion(Square from, Square to) const {
+    for (Move m : legal) {
+        if (fromSq(m) == from && toSq(m) == to && typeOfMove(m) == PROMOTION) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// regenerate the reply list once and derive the game state from it
+MoveResult Game::refresh() {
+    legal.clear();
+    generateLegalMoves(pos, legal);
+
+    if (legal.size() == 0) {
+        if (pos.inCheck()) {
+            state = pos.sideToMove() == WHITE ? GAME_BLACK_WINS : GAME_WHITE_WINS;
+            return MOVE_CHECKMATE;
+        }
+        state = GAME_DRAW;
+        return MOVE_STALEMATE;
+    }
+    state = GAME_PLAYING;
+    return pos.inCheck() ? MOVE_CHECK : MOVE_OK;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <string>
+#include "MoveGen.h"
+
+// outcome of applyMove, seen from the side that just moved
+enum MoveResult {
+    MOVE_ILLEGAL,
+    MOVE_OK,
+    MOVE_CHECK,
+    MOVE_CHECKMATE,
+    MOVE_STALEMATE
+};
+
+enum GameStatus {
+    GAME_PLAYING,
+    GAME_WHITE_WINS,
+    GAME_BLACK_WINS,
+    GAME_DRAW
+};
+
+// a whole game in 46 bytes (no move history), see GamePool
+struct PackedGame {
+    PackedPosition pos;
+    int16_t scores[COLOR_NB];
+    uint8_t state;
+    uint8_t lastCapture;
+    uint16_t lastMove;
+};
+
+static_assert(sizeof(PackedGame) == 46, "packed game is 46 bytes");
+
+// one game of chess without any window or global state: validates and
+// plays moves, tracks captures/scores and detects check, mate and stalemate
+class Game {
+public:
+    Game();
+
+    void reset();
+    bool setFen(const std::string& fen);
+
+    // save / restore the game without its move history; load() regenerates
+    // the legal moves, so a restored game plays on like the original
+    void save(PackedGame& pg) const;
+    void load(const PackedGame& pg);
+    // the same with the legal moves of pg already generated, e.g. by the
+    // thread that saved it
+    void load(const PackedGame& pg, const MoveList& legalMoves);
+
+    // play from -> to for the side to move; promo picks the promotion piece
+    MoveResult applyMove(Square from, Square to, PieceType promo = QUEEN);
+    MoveResult applyMove(Move m);
+
+    // the legal move from -> to (promo for promotions), MOVE_NONE if none
+    Move findMove(Square from, Square to, PieceType promo = QUEEN) const;
+
+    // true if from -> to is a legal pawn move onto the last rank
+    bool isPromotion(Square from, Square to) const;
+
+    // legal moves of the side to move, computed once per move
+    const MoveList& legalMoves() const { return legal; }
+
+    const Position& position() const { return pos; }
+    Color sideToMove() const { return pos.sideToMove(); }
+    bool inCheck() const { return pos.inCheck(); }
+    GameStatus status() const { return state; }
+    bool isOver() const { return state != GAME_PLAYING; }
+    int score(Color c) const { return scores[c]; }
+
+    // piece taken by the last move, NO_PIECE if it was quiet
+    Piece lastCaptured() const { return lastCapture; }
+    Move lastMove() const { return pos.historySize() ? pos.lastMove() : loadedLastMove; }
+
+private:
+    MoveResult refresh();
+
+    Position pos;
+    MoveList legal;
+    GameStatus state;
+    int scores[COLOR_NB];
+    Piece lastCapture;
+    Move loadedLastMove;  // last move before load(), the history is gone
+};
@@ -0,0 +1,545 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <queue>
+#include <thread>
+#include "GameDb.h"
+
+using namespace std;
+
+static const char GamesMagic[8] = { 'C', 'H', 'E', 'S', 'S', 'D', 'B', 'G' };
+static const char HeadersMagic[8] = { 'C', 'H', 'E', 'S', 'S', 'D', 'B', 'H' };
+static const char IndexMagic[8] = { 'C', 'H', 'E', 'S', 'S', 'D', 'B', 'I' };
+
+const int MaxBucketBits = 24;
+
+static bool readHeader(FILE* f, const char* magic, DbFileHeader& h) {
+    return seekFile(f, 0, SEEK_SET) == 0 && fread(&h, sizeof(h), 1, f) == 1
+        && memcmp(h.magic, magic, 8) == 0 && h.version == DbVersion;
+}
+
+static bool writeHeader(FILE* f, const char* magic, uint64_t count) {
+    DbFileHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, magic, 8);
+    h.version = DbVersion;
+    h.count = count;
+    return seekFile(f, 0, SEEK_SET) == 0 && fwrite(&h, sizeof(h), 1, f) == 1;
+}
+
+// existing file for update, or a new one with an empty header
+static FILE* openForAppend(const string& path, const char* magic, uint64_t& count) {
+    FILE* f = fopen(path.c_str(), "r+b");
+    if (f) {
+        DbFileHeader h;
+        if (!readHeader(f, magic, h)) {
+            fclose(f);
+            return nullptr;
+        }
+        count = h.count;
+        return f;
+    }
+    f = fopen(path.c_str(), "w+b");
+    if (f && !writeHeader(f, magic, 0)) {
+        fclose(f);
+        return nullptr;
+    }
+    count = 0;
+    return f;
+}
+
+// "2019.04.??" -> 20190400
+static uint32_t parseDate(const string* date) {
+    if (!date || date->size() < 10) {
+        return 0;
+    }
+    const string& d = *date;
+    auto field = [&](size_t at, size_t length) {
+        uint32_t v = 0;
+        for (size_t i = at; i < at + length; i++) {
+            if (d[i] < '0' || d[i] > '9') {
+                return 0u;
+            }
+            v = v * 10 + (d[i] - '0');
+        }
+        return v;
+    };
+    return field(0, 4) * 10000 + field(5, 2) * 100 + field(8, 2);
+}
+
+static uint16_t parseElo(const string* elo) {
+    return elo ? (uint16_t)min(atoi(elo->c_str()), 65535) : 0;
+}
+
+GameDbWriter::GameDbWriter() : gamesFile(nullptr), headersFile(nullptr), count(0), gamesBytes(0) {}
+
+GameDbWriter::~GameDbWriter() {
+    close();
+}
+
+bool GameDbWriter::open(const string& base) {
+    close();
+    gamesFile = openForAppend(base + ".games", GamesMagic, gamesBytes);
+    headersFile = openForAppend(base + ".headers", HeadersMagic, count);
+    if (!gamesFile || !headersFile) {
+        close();
+        return false;
+    }
+    // anything behind the counts is from an append that never closed
+    seekFile(gamesFile, sizeof(DbFileHeader) + gamesBytes, SEEK_SET);
+    seekFile(headersFile, sizeof(DbFileHeader) + count * sizeof(GameEntry), SEEK_SET);
+    return true;
+}
+
+void GameDbWriter::close() {
+    if (gamesFile && headersFile) {
+        writeHeader(gamesFile, GamesMagic, gamesBytes);
+        fflush(gamesFile);
+        writeHeader(headersFile, HeadersMagic, count);
+    }
+    if (gamesFile) {
+        fclose(gamesFile);
+    }
+    if (headersFile) {
+        fclose(headersFile);
+    }
+    gamesFile = headersFile = nullptr;
+}
+
+bool GameDbWriter::add(const PgnGame& game) {
+    GameEntry e;
+    memset(&e, 0, sizeof(e));
+    record.clear();
+
+    if (!game.fen.empty()) {
+        if (!pos.setFen(game.fen)) {
+            return false;
+        }
+        PackedPosition pp;
+        pos.pack(pp);
+        record.insert(record.end(), (const char*)&pp, (const char*)&pp + sizeof(pp));
+        e.flags |= GAME_SETUP;
+    }
+
+    // tags, the FEN is already in the packed start position
+    size_t tagsAt = record.size();
+    for (int i = 0; i < game.tagCount; i++) {
+        const PgnTag& t = game.tags[i];
+        if (t.name == "FEN" || t.name == "SetUp") {
+            continue;
+        }
+        if (record.size() - tagsAt + t.name.size() + t.value.size() + 2 > 65534) {
+            break;
+        }
+        record.insert(record.end(), t.name.begin(), t.name.end());
+        record.push_back('\0');
+        record.insert(record.end(), t.value.begin(), t.value.end());
+        record.push_back('\0');
+    }
+    if ((record.size() - tagsAt) & 1) {
+        record.push_back('\0'); // moves stay 2-byte aligned
+    }
+    e.tagBytes = uint16_t(record.size() - tagsAt);
+
+    size_t n = min(game.moves.size(), (size_t)65535);
+    record.insert(record.end(), (const char*)game.moves.data(), (const char*)(game.moves.data() + n));
+    e.moveCount = uint16_t(n);
+
+    e.offset = sizeof(DbFileHeader) + gamesBytes;
+    e.result = game.result;
+    if (!game.error.empty()) {
+        e.flags |= GAME_ERROR;
+    }
+    e.whiteElo = parseElo(game.tag("WhiteElo"));
+    e.blackElo = parseElo(game.tag("BlackElo"));
+    e.date = parseDate(game.tag("Date"));
+
+    if (fwrite(record.data(), 1, record.size(), gamesFile) != record.size()
+        || fwrite(&e, sizeof(e), 1, headersFile) != 1) {
+        return false;
+    }
+    gamesBytes += record.size();
+    count++;
+    return true;
+}
+
+bool GameDb::open(const string& base) {
+    close();
+    if (!gamesMap.open(base + ".games") || !headersMap.open(base + ".headers")) {
+        close();
+        return false;
+    }
+    const DbFileHeader* gh = (const DbFileHeader*)gamesMap.data();
+    const DbFileHeader* hh = (const DbFileHeader*)headersMap.data();
+    if (gamesMap.size() < sizeof(DbFileHeader) || headersMap.size() < sizeof(DbFileHeader)
+        || memcmp(gh->magic, GamesMagic, 8) != 0 || memcmp(hh->magic, HeadersMagic, 8) != 0
+        || gh->version != DbVersion || hh->version != DbVersion
+        || headersMap.size() < sizeof(DbFileHeader) + hh->count * sizeof(GameEntry)) {
+        close();
+        return false;
+    }
+    entries = (const GameEntry*)(headersMap.data() + sizeof(DbFileHeader));
+    gameCount = hh->count;
+
+    // an index that doesn't fit the games is ignored
+    if (indexMap.open(base + ".index") && indexMap.size() >= sizeof(DbIndexHeader)) {
+        const DbIndexHeader* ih = (const DbIndexHeader*)indexMap.data();
+        uint64_t tableBytes = ((1ULL << ih->bucketBits) + 1) * sizeof(uint64_t);
+        if (memcmp(ih->magic, IndexMagic, 8) == 0 && ih->version == DbVersion
+            && ih->bucketBits <= MaxBucketBits && ih->games <= gameCount
+            && indexMap.size() >= sizeof(DbIndexHeader) + tableBytes + ih->entries * sizeof(IndexEntry)) {
+            index = ih;
+            buckets = (const uint64_t*)(indexMap.data() + sizeof(DbIndexHeader));
+            records = (const IndexEntry*)(indexMap.data() + sizeof(DbIndexHeader) + tableBytes);
+        }
+    }
+    if (!index) {
+        indexMap.close();
+    }
+    return true;
+}
+
+void GameDb::close() {
+    gamesMap.close();
+    headersMap.close();
+    indexMap.close();
+    entries = nullptr;
+    gameCount = 0;
+    index = nullptr;
+    buckets = nullptr;
+    records = nullptr;
+}
+
+const Move* GameDb::moves(uint32_t id) const {
+    const GameEntry& e = entries[id];
+    size_t at = e.offset + ((e.flags & GAME_SETUP) ? sizeof(PackedPosition) : 0) + e.tagBytes;
+    return (const Move*)(gamesMap.data() + at);
+}
+
+bool GameDb::startPosition(uint32_t id, Position& pos) const {
+    const GameEntry& e = entries[id];
+    if (e.flags & GAME_SETUP) {
+        PackedPosition pp;
+        memcpy(&pp, gamesMap.data() + e.offset, sizeof(pp));
+        pos.unpack(pp);
+    }
+    else {
+        pos.setStartPosition();
+    }
+    return true;
+}
+
+string GameDb::tag(uint32_t id, const char* name) const {
+    const GameEntry& e = entries[id];
+    const char* p = gamesMap.data() + e.offset + ((e.flags & GAME_SETUP) ? sizeof(PackedPosition) : 0);
+    const char* end = p + e.tagBytes;
+    while (p < end && *p) {
+        const char* value = p + strlen(p) + 1;
+        if (strcmp(p, name) == 0) {
+            return value;
+        }
+        p = value + strlen(value) + 1;
+    }
+    return "";
+}
+
+void GameDb::lookup(uint64_t key, const IndexEntry*& first, const IndexEntry*& last) const {
+    first = last = records;
+    if (!index || !index->entries) {
+        return;
+    }
+    // the bucket table narrows the search to the keys sharing the top bits
+    uint64_t b = index->bucketBits ? key >> (64 - index->bucketBits) : 0;
+    const IndexEntry* lo = records + buckets[b];
+    const IndexEntry* hi = records + buckets[b + 1];
+    first = lower_bound(lo, hi, key, [](const IndexEntry& e, uint64_t k) { return e.key < k; });
+    last = upper_bound(first, hi, key, [](uint64_t k, const IndexEntry& e) { return k < e.key; });
+}
+
+template <typename Visit>
+void GameDb::scanUnindexed(uint64_t key, Visit visit) const {
+    Position pos;
+    uint32_t maxPly = index ? index->maxPly : 0;
+    for (uint64_t id = indexedGames(); id < gameCount; id++) {
+        const GameEntry& e = entries[id];
+        if (e.flags & GAME_ERROR) {
+            continue; // not indexed either
+        }
+        const Move* ms = moves(uint32_t(id));
+        startPosition(uint32_t(id), pos);
+        int plies = maxPly ? min<int>(e.moveCount, maxPly) : e.moveCount;
+        for (int ply = 0; ply <= plies; ply++) {
+            if (pos.key() == key) {
+                visit(uint32_t(id), ply < e.moveCount ? ms[ply] : MOVE_NONE, e.result);
+                break;
+            }
+            if (ply < plies) {
+                pos.makeMove(ms[ply]);
+            }
+        }
+    }
+}
+
+void GameDb::gamesWith(const Position& pos, vector<uint32_t>& ids, size_t limit) const {
+    ids.clear();
+    const IndexEntry* first;
+    const IndexEntry* last;
+    lookup(pos.key(), first, last);
+    for (const IndexEntry* e = first; e < last && ids.size() < limit; e++) {
+        ids.push_back(e->game);
+    }
+    if (ids.size() < limit) {
+        scanUnindexed(pos.key(), [&](uint32_t id, Move, uint8_t) {
+            if (ids.size() < limit) {
+                ids.push_back(id);
+            }
+        });
+    }
+}
+
+void GameDb::moveStats(const Position& pos, vector<MoveStats>& stats) const {
+    stats.clear();
+    auto count = [&](Move m, uint8_t result) {
+        if (m == MOVE_NONE) {
+            return;
+        }
+        size_t i = 0;
+        while (i < stats.size() && stats[i].move != m) {
+            i++;
+        }
+        if (i == stats.size()) {
+            stats.push_back({ m, 0, 0, 0, 0 });
+        }
+        MoveStats& s = stats[i];
+        s.games++;
+        s.whiteWins += result == PGN_WHITE_WINS;
+        s.draws += result == PGN_DRAW;
+        s.blackWins += result == PGN_BLACK_WINS;
+    };
+    const IndexEntry* first;
+    const IndexEntry* last;
+    lookup(pos.key(), first, last);
+    for (const IndexEntry* e = first; e < last; e++) {
+        count(e->move, e->result);
+    }
+    scanUnindexed(pos.key(), [&](uint32_t, Move m, uint8_t result) { count(m, result); });
+    sort(stats.begin(), stats.end(), [](const MoveStats& a, const MoveStats& b) { return a.games > b.games; });
+}
+
+static bool entryLess(const IndexEntry& a, const IndexEntry& b) {
+    return a.key < b.key || (a.key == b.key && a.game < b.game);
+}
+
+// memory for the sorted runs of all builder threads together; a full run
+// is sorted and spilled to its own file, the files are merged at the end
+const size_t SortBufferBytes = size_t(256) << 20;
+// entries read from each run file at a time during the merge
+const size_t MergeChunk = 4096;
+
+struct RunFile {
+    string path;
+    uint64_t entries;
+};
+
+// sorts a run, drops repeated positions of a game and writes it to path
+static bool spillRun(vector<IndexEntry>& run, const string& path, vector<RunFile>& files) {
+    // stable: a repeated position keeps the move from its first visit
+    stable_sort(run.begin(), run.end(), entryLess);
+    run.erase(unique(run.begin(), run.end(), [](const IndexEntry& a, const IndexEntry& b) {
+        return a.key == b.key && a.game == b.game;
+    }), run.end());
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) {
+        return false;
+    }
+    files.push_back({ path, run.size() });
+    bool ok = fwrite(run.data(), sizeof(IndexEntry), run.size(), f) == run.size();
+    ok = fclose(f) == 0 && ok;
+    run.clear();
+    return ok;
+}
+
+// sorted runs of the positions of games [begin, end), first occurrence per
+// game only, spilled to files named prefix + number once a run holds limit
+// entries (a game never spans two runs). Games cut short by a bad move are
+// left out, their last position and result would count as a finished game.
+static bool buildRuns(const GameDb& db, uint32_t begin, uint32_t end, int maxPly, size_t limit,
+                      const string& prefix, vector<RunFile>& files) {
+    vector<IndexEntry> run;
+    run.reserve(limit);
+    Position pos;
+    for (uint32_t id = begin; id < end; id++) {
+        const GameEntry& e = db.entry(id);
+        if (e.flags & GAME_ERROR) {
+            continue;
+        }
+        const Move* ms = db.moves(id);
+        db.startPosition(id, pos);
+        int plies = maxPly ? min<int>(e.moveCount, maxPly) : e.moveCount;
+        for (int ply = 0; ply <= plies; ply++) {
+            IndexEntry ie;
+            ie.key = pos.key();
+            ie.game = id;
+            ie.move = ply < e.moveCount ? ms[ply] : MOVE_NONE;
+            ie.result = e.result;
+            ie.reserved = 0;
+            run.push_back(ie);
+            if (ply < plies) {
+                pos.makeMove(ms[ply]);
+            }
+        }
+        if (run.size() >= limit && !spillRun(run, prefix + to_string(files.size()), files)) {
+            return false;
+        }
+    }
+    return run.empty() || spillRun(run, prefix + to_string(files.size()), files);
+}
+
+// a run file read back a chunk at a time
+struct RunReader {
+    FILE* file = nullptr;
+    vector<IndexEntry> chunk;
+    size_t at = 0;
+
+    // false once the run is used up
+    bool fill() {
+        chunk.resize(MergeChunk);
+        chunk.resize(fread(chunk.data(), sizeof(IndexEntry), MergeChunk, file));
+        at = 0;
+        return !chunk.empty();
+    }
+    const IndexEntry& current() const { return chunk[at]; }
+    bool advance() { return ++at < chunk.size() || fill(); }
+};
+
+bool buildDbIndex(const string& base, int threads, int maxPly) {
+    GameDb db;
+    if (!db.open(base)) {
+        return false;
+    }
+    if (threads <= 0) {
+        threads = max(1u, thread::hardware_concurrency());
+    }
+    uint32_t games = uint32_t(db.games());
+    threads = max(1, min<int>(threads, games));
+    size_t limit = max(SortBufferBytes / sizeof(IndexEntry) / threads, size_t(1) << 16);
+
+    vector<vector<RunFile>> files(threads);
+    vector<char> built(threads, 0);
+    vector<thread> workers;
+    for (int t = 0; t < threads; t++) {
+        uint32_t begin = uint32_t((uint64_t)games * t / threads);
+        uint32_t end = uint32_t((uint64_t)games * (t + 1) / threads);
+        string prefix = base + ".index.run" + to_string(t) + ".";
+        workers.emplace_back([&, t, begin, end, prefix] {
+            built[t] = buildRuns(db, begin, end, maxPly, limit, prefix, files[t]);
+        });
+    }
+    for (thread& w : workers) {
+        w.join();
+    }
+
+    vector<RunFile> runs;
+    bool ok = true;
+    for (int t = 0; t < threads; t++) {
+        ok = ok && built[t];
+        runs.insert(runs.end(), files[t].begin(), files[t].end());
+    }
+    auto removeRuns = [&] {
+        for (const RunFile& r : runs) {
+            remove(r.path.c_str());
+        }
+    };
+    if (!ok) {
+        removeRuns();
+        return false;
+    }
+
+    uint64_t total = 0;
+    for (const RunFile& r : runs) {
+        total += r.entries;
+    }
+    // about 16 entries per bucket
+    int bits = 0;
+    while (bits < MaxBucketBits && (total >> (bits + 4)) > 1) {
+        bits++;
+    }
+    vector<uint64_t> table((1ULL << bits) + 1, 0);
+
+    string tmpPath = base + ".index.tmp";
+    FILE* f = fopen(tmpPath.c_str(), "wb");
+    if (!f) {
+        removeRuns();
+        return false;
+    }
+    DbIndexHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, IndexMagic, 8);
+    h.version = DbVersion;
+    h.bucketBits = bits;
+    h.entries = total;
+    h.games = games;
+    h.maxPly = maxPly;
+    ok = fwrite(&h, sizeof(h), 1, f) == 1;
+    ok = ok && fwrite(table.data(), sizeof(uint64_t), table.size(), f) == table.size();
+
+    // k-way merge of the run files; the runs hold disjoint game ranges, so
+    // keys compare equal only across games and the output stays in game order
+    vector<RunReader> readers(runs.size());
+    for (size_t i = 0; i < runs.size() && ok; i++) {
+        readers[i].file = fopen(runs[i].path.c_str(), "rb");
+        ok = readers[i].file != nullptr;
+    }
+    auto later = [&](size_t a, size_t b) { return entryLess(readers[b].current(), readers[a].current()); };
+    priority_queue<size_t, vector<size_t>, decltype(later)> heap(later);
+    for (size_t i = 0; i < readers.size() && ok; i++) {
+        if (readers[i].fill()) {
+            heap.push(i);
+        }
+    }
+    vector<IndexEntry> out;
+    out.reserve(1 << 16);
+    uint64_t written = 0;
+    while (!heap.empty() && ok) {
+        size_t i = heap.top();
+        heap.pop();
+        const IndexEntry& e = readers[i].current();
+        table[bits ? (e.key >> (64 - bits)) + 1 : 1]++;
+        out.push_back(e);
+        if (out.size() == out.capacity()) {
+            ok = fwrite(out.data(), sizeof(IndexEntry), out.size(), f) == out.size();
+            written += out.size();
+            out.clear();
+        }
+        if (readers[i].advance()) {
+            heap.push(i);
+        }
+    }
+    ok = ok && fwrite(out.data(), sizeof(IndexEntry), out.size(), f) == out.size();
+    written += out.size();
+    // a short read shows as entries missing from the merge
+    ok = ok && written == total;
+    for (RunReader& r : readers) {
+        if (r.file) {
+            fclose(r.file);
+        }
+    }
+    removeRuns();
+
+    // bucket b starts at table[b]: prefix sums of the counts
+    for (size_t b = 1; b < table.size(); b++) {
+        table[b] += table[b - 1];
+    }
+    ok = ok && seekFile(f, sizeof(h), SEEK_SET) == 0
+        && fwrite(table.data(), sizeof(uint64_t), table.size(), f) == table.size();
+    ok = fclose(f) == 0 && ok;
+    db.close();
+
+    string indexPath = base + ".index";
+    if (!ok) {
+        remove(tmpPath.c_str());
+        return false;
+    }
+    remove(indexPath.c_str()); // rename does not replace on Windows
+    return rename(tmpPath.c_str(), indexPath.c_str()) == 0;
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+#include "Pgn.h"
+#include "Position.h"
+
+// GAME DATABASE
+// three files next to each other, all little-endian and read through
+// memory maps, so queries touch the stored structs directly:
+//   <base>.games    DbFileHeader, then one record per game: the start
+//                   position (PackedPosition, only for set-up games), the
+//                   tags ("Name\0Value\0" pairs, padded to even length) and
+//                   the moves as 16-bit Move codes
+//   <base>.headers  DbFileHeader (count = games), then one GameEntry per game
+//   <base>.index    DbIndexHeader, a bucket table and IndexEntry records
+//                   sorted by position key: one per position a game
+//                   reached (first occurrence, up to maxPly); games
+//                   flagged GAME_ERROR are stored but not indexed
+// Games are only ever appended. The index records how many games it
+// covers; games appended after it are found by replaying them until the
+// index is rebuilt (buildDbIndex).
+
+const uint32_t DbVersion = 1;
+
+struct DbFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved0;
+    uint64_t count;     // games (headers file) / bytes of records (games file)
+    uint64_t reserved[5];
+};
+
+enum GameFlags : uint8_t {
+    GAME_SETUP = 1,  // record starts with a PackedPosition
+    GAME_ERROR = 2   // the PGN had moves after the stored ones that didn't resolve
+};
+
+struct GameEntry {
+    uint64_t offset;     // record in the games file
+    uint16_t moveCount;
+    uint16_t tagBytes;
+    uint8_t result;      // PgnResult
+    uint8_t flags;       // GameFlags
+    uint16_t whiteElo;
+    uint16_t blackElo;
+    uint16_t reserved;
+    uint32_t date;       // yyyymmdd, 0 for unknown parts
+};
+
+struct DbIndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t bucketBits;  // table has (1 << bucketBits) + 1 entries
+    uint64_t entries;
+    uint64_t games;       // games [0, games) are indexed
+    uint32_t maxPly;      // 0 = whole games
+    uint32_t reserved0;
+    uint64_t reserved[3];
+};
+
+struct IndexEntry {
+    uint64_t key;
+    uint32_t game;
+    uint16_t move;    // move played from the position, MOVE_NONE if the game ended there
+    uint8_t result;   // the game's PgnResult, so statistics need no header lookup
+    uint8_t reserved;
+};
+
+static_assert(sizeof(DbFileHeader) == 64 && sizeof(DbIndexHeader) == 64, "file headers are 64 bytes");
+static_assert(sizeof(GameEntry) == 24 && sizeof(IndexEntry) == 16, "database records are packed");
+
+// games that continued with one move from a position
+struct MoveStats {
+    Move move;
+    uint32_t games;
+    uint32_t whiteWins;
+    uint32_t draws;
+    uint32_t blackWins;
+};
+
+// appends games. The game counts in the file headers are only written by
+// close(), games file first, so a reader (or a crash) never sees a game
+// whose record is incomplete.
+class GameDbWriter {
+public:
+    GameDbWriter();
+    ~GameDbWriter();
+
+    // opens the database for appending, creating empty files if needed
+    bool open(const std::string& base);
+    void close();
+
+    // false if the game's start position is invalid
+    bool add(const PgnGame& game);
+    uint64_t games() const { return count; }
+
+private:
+    FILE* gamesFile;
+    FILE* headersFile;
+    uint64_t count;
+    uint64_t gamesBytes;
+    std::vector<char> record;  // reused per game
+    Position pos;
+};
+
+// read-only view of a database
+class GameDb {
+public:
+    // the index is optional; without one every query replays all games
+    bool open(const std::string& base);
+    void close();
+
+    uint64_t games() const { return gameCount; }
+    uint64_t indexedGames() const { return index ? index->games : 0; }
+    uint64_t indexEntries() const { return index ? index->entries : 0; }
+
+    const GameEntry& entry(uint32_t id) const { return entries[id]; }
+    const Move* moves(uint32_t id) const;
+    bool startPosition(uint32_t id, Position& pos) const;
+    // value of a stored tag, empty if absent
+    std::string tag(uint32_t id, const char* name) const;
+
+    // games that reached pos (by key), at most limit ids, in game order;
+    // like moveStats() this leaves out games flagged GAME_ERROR
+    void gamesWith(const Position& pos, std::vector<uint32_t>& ids, size_t limit = SIZE_MAX) const;
+    // moves played from pos with their results, most played first
+    void moveStats(const Position& pos, std::vector<MoveStats>& stats) const;
+
+private:
+    // index entries with this key: [first, last)
+    void lookup(uint64_t key, const IndexEntry*& first, const IndexEntry*& last) const;
+    // replays the games the index doesn't cover yet
+    template <typename Visit>
+    void scanUnindexed(uint64_t key, Visit visit) const;
+
+    MappedFile gamesMap;
+    MappedFile headersMap;
+    MappedFile indexMap;
+    const GameEntry* entries = nullptr;
+    uint64_t gameCount = 0;
+    const DbIndexHeader* index = nullptr;
+    const uint64_t* buckets = nullptr;
+    const IndexEntry* records = nullptr;
+};
+
+// (re)builds <base>.index over all games with threads threads (0 = all
+// cores): each replays a share of the games into sorted runs of bounded
+// size spilled to files next to the index, the run files are merged into a
+// temporary file that replaces the old index
+bool buildDbIndex(const std::string& base, int threads, int maxPly);
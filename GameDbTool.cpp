@@ -0,0 +1,168 @@
+// headless game database tool: imports PGN into the binary database,
+// rebuilds its position index and answers opening-explorer queries
+//
+// usage: gamedb import <base> <file.pgn> [--threads N] [--plies N]
+//        gamedb index <base> [--threads N] [--plies N]
+//        gamedb info <base>
+//        gamedb stats <base> [--fen "<fen>"] [--moves "e4 e5 Nf3"]
+//        gamedb games <base> [--fen "<fen>"] [--moves "..."] [--limit N]
+//   --threads N   index builder threads (0 = all cores)
+//   --plies N     only index the first N plies of every game (0 = all)
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "GameDb.h"
+#include "MoveGen.h"
+
+using namespace std;
+
+static const char* resultString(int result) {
+    switch (result) {
+    case PGN_WHITE_WINS: return "1-0";
+    case PGN_BLACK_WINS: return "0-1";
+    case PGN_DRAW: return "1/2-1/2";
+    default: return "*";
+    }
+}
+
+static void usage() {
+    cout << "usage: gamedb import <base> <file.pgn> [--threads N] [--plies N]" << endl;
+    cout << "       gamedb index <base> [--threads N] [--plies N]" << endl;
+    cout << "       gamedb info <base>" << endl;
+    cout << "       gamedb stats <base> [--fen \"<fen>\"] [--moves \"e4 e5 Nf3\"]" << endl;
+    cout << "       gamedb games <base> [--fen \"<fen>\"] [--moves \"...\"] [--limit N]" << endl;
+}
+
+static double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static bool rebuildIndex(const string& base, int threads, int plies) {
+    auto start = chrono::steady_clock::now();
+    if (!buildDbIndex(base, threads, plies)) {
+        cout << "index build failed" << endl;
+        return false;
+    }
+    GameDb db;
+    db.open(base);
+    cout << "indexed " << db.indexedGames() << " games, " << db.indexEntries() << " positions in "
+         << secondsSince(start) << " s" << endl;
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    initBitboards();
+    if (argc < 3) {
+        usage();
+        return 1;
+    }
+    string command = argv[1];
+    string base = argv[2];
+    string pgnPath;
+    string fen = StartFEN;
+    string moves;
+    int threads = 0;
+    int plies = 0;
+    size_t limit = 20;
+    for (int i = 3; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) { threads = atoi(argv[++i]); }
+        else if (arg == "--plies" && i + 1 < argc) { plies = atoi(argv[++i]); }
+        else if (arg == "--fen" && i + 1 < argc) { fen = argv[++i]; }
+        else if (arg == "--moves" && i + 1 < argc) { moves = argv[++i]; }
+        else if (arg == "--limit" && i + 1 < argc) { limit = strtoull(argv[++i], nullptr, 10); }
+        else { pgnPath = arg; }
+    }
+
+    if (command == "import") {
+        PgnReader reader;
+        if (pgnPath.empty() || !reader.open(pgnPath)) {
+            cout << "can't open " << pgnPath << endl;
+            return 1;
+        }
+        GameDbWriter writer;
+        if (!writer.open(base)) {
+            cout << "can't open database " << base << endl;
+            return 1;
+        }
+        auto start = chrono::steady_clock::now();
+        uint64_t before = writer.games(), skipped = 0, cut = 0;
+        PgnGame game;
+        while (reader.next(game)) {
+            if (!writer.add(game)) {
+                skipped++;
+            }
+            else if (!game.error.empty()) {
+                cut++;
+            }
+        }
+        uint64_t added = writer.games() - before;
+        writer.close();
+        cout << "added " << added << " games (" << skipped << " skipped, " << cut
+             << " with unresolved moves, not indexed) in " << secondsSince(start) << " s" << endl;
+        return rebuildIndex(base, threads, plies) ? 0 : 1;
+    }
+    if (command == "index") {
+        return rebuildIndex(base, threads, plies) ? 0 : 1;
+    }
+
+    GameDb db;
+    if (!db.open(base)) {
+        cout << "can't open database " << base << endl;
+        return 1;
+    }
+    if (command == "info") {
+        cout << "games    " << db.games() << endl;
+        cout << "indexed  " << db.indexedGames() << " games, " << db.indexEntries() << " positions" << endl;
+        return 0;
+    }
+
+    // query position: the FEN, then the SAN moves from it
+    Position pos;
+    if (!pos.setFen(fen)) {
+        cout << "invalid fen: " << fen << endl;
+        return 1;
+    }
+    istringstream ss(moves);
+    string san;
+    while (ss >> san) {
+        Move m = parseSan(pos, san.c_str(), san.size());
+        if (m == MOVE_NONE) {
+            cout << "illegal move: " << san << endl;
+            return 1;
+        }
+        pos.makeMove(m);
+    }
+
+    if (command == "stats") {
+        vector<MoveStats> stats;
+        auto start = chrono::steady_clock::now();
+        db.moveStats(pos, stats);
+        double us = secondsSince(start) * 1e6;
+        for (const MoveStats& s : stats) {
+            cout << moveToSan(pos, s.move) << "\t" << s.games << " games\t+" << s.whiteWins << " =" << s.draws
+                 << " -" << s.blackWins << endl;
+        }
+        cout << "lookup " << us << " us" << endl;
+        return 0;
+    }
+    if (command == "games") {
+        vector<uint32_t> ids;
+        auto start = chrono::steady_clock::now();
+        db.gamesWith(pos, ids, limit);
+        double us = secondsSince(start) * 1e6;
+        for (uint32_t id : ids) {
+            const GameEntry& e = db.entry(id);
+            cout << "#" << id << "  " << db.tag(id, "White") << " - " << db.tag(id, "Black") << "  "
+                 << resultString(e.result) << "  " << e.moveCount << " plies" << endl;
+        }
+        cout << "lookup " << us << " us" << endl;
+        return 0;
+    }
+    usage();
+    return 1;
+}
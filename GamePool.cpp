@@ -0,0 +1,176 @@
+#include "GamePool.h"
+
+using namespace std;
+
+GamePool::GamePool(int workerCount, ReplyHandler handler)
+    : onReplies(handler), chunkCount(0), freeHead(NoSlot), live(0), done(0) {
+    Game g;
+    g.save(startGame);
+
+    workerCount = max(1, workerCount);
+    for (int i = 0; i < workerCount; i++) {
+        workers.push_back(unique_ptr<Worker>(new Worker()));
+    }
+    for (auto& w : workers) {
+        Worker* wp = w.get();
+        w->thread = thread([this, wp] { work(*wp); });
+    }
+}
+
+GamePool::~GamePool() {
+    // workers finish what is queued before they leave
+    for (auto& w : workers) {
+        lock_guard<mutex> lock(w->mutex);
+        w->quitting = true;
+    }
+    for (auto& w : workers) {
+        w->cv.notify_one();
+        w->thread.join();
+    }
+}
+
+size_t GamePool::slotBytes() {
+    static_assert(sizeof(Slot) == 56, "a pooled game is 56 bytes, within a cache line");
+    return sizeof(Slot);
+}
+
+bool GamePool::create(GameHandle& handle, const string& fen) {
+    PackedGame initial = startGame;
+    if (fen != StartFEN) {
+        Game g;
+        if (!g.setFen(fen)) {
+            return false;
+        }
+        g.save(initial);
+    }
+
+    lock_guard<mutex> lock(slabMutex);
+    if (freeHead == NoSlot) {
+        if (chunkCount == MaxChunks) {
+            return false;
+        }
+        // new chunk, its slots go on the free list lowest index first
+        chunks[chunkCount].reset(new Slot[ChunkSize]);
+        uint32_t base = (uint32_t)chunkCount << ChunkBits;
+        for (uint32_t i = 0; i < ChunkSize; i++) {
+            Slot& s = chunks[chunkCount][i];
+            s.generation.store(0, memory_order_relaxed);
+            s.nextFree = i + 1 < ChunkSize ? base + i + 1 : NoSlot;
+        }
+        freeHead = base;
+        chunkCount++;
+    }
+
+    uint32_t index = freeHead;
+    Slot& s = slot(index);
+    freeHead = s.nextFree;
+    s.game = initial;
+    handle.index = index;
+    handle.generation = s.generation.load(memory_order_relaxed) + 1;
+    s.generation.store(handle.generation, memory_order_release);
+    live.fetch_add(1, memory_order_relaxed);
+    return true;
+}
+
+void GamePool::release(uint32_t index) {
+    lock_guard<mutex> lock(slabMutex);
+    Slot& s = slot(index);
+    s.generation.store(s.generation.load(memory_order_relaxed) + 1, memory_order_release);
+    s.nextFree = freeHead;
+    freeHead = index;
+    live.fetch_sub(1, memory_order_relaxed);
+}
+
+void GamePool::submit(const GameRequest* reqs, size_t count) {
+    size_t n = workers.size();
+    for (size_t w = 0; w < n; w++) {
+        bool added = false;
+        {
+            lock_guard<mutex> lock(workers[w]->mutex);
+            for (size_t i = 0; i < count; i++) {
+                if (reqs[i].game.index % n == w) {
+                    workers[w]->queue.push_back(reqs[i]);
+                    added = true;
+                }
+            }
+        }
+        if (added) {
+            workers[w]->cv.notify_one();
+        }
+    }
+}
+
+void GamePool::submitMove(GameHandle g, Square from, Square to, PieceType promo, uint64_t tag, Color side) {
+    GameRequest req = { g, REQUEST_MOVE, uint8_t(from), uint8_t(to), uint8_t(promo), uint8_t(side), tag };
+    submit(req);
+}
+
+void GamePool::close(GameHandle g, uint64_t tag) {
+    GameRequest req = { g, REQUEST_CLOSE, 0, 0, 0, COLOR_NB, tag };
+    submit(req);
+}
+
+void GamePool::work(Worker& w) {
+    vector<GameRequest> batch;
+    vector<GameReply> replies;
+    Game scratch;
+    uint32_t loaded = NoSlot;  // slot the scratch game currently mirrors
+
+    while (true) {
+        {
+            unique_lock<mutex> lock(w.mutex);
+            w.cv.wait(lock, [&] { return !w.queue.empty() || w.quitting; });
+            if (w.queue.empty()) {
+                return;
+            }
+            batch.swap(w.queue);
+        }
+
+        replies.clear();
+        for (const GameRequest& req : batch) {
+            GameReply reply;
+            reply.game = req.game;
+            reply.type = req.type;
+            reply.tag = req.tag;
+            reply.result = MOVE_ILLEGAL;
+            reply.move = MOVE_NONE;
+
+            Slot& s = slot(req.game.index);
+            reply.found = s.generation.load(memory_order_acquire) == req.game.generation;
+            if (!reply.found) {
+                replies.push_back(reply);
+                continue;
+            }
+
+            if (req.type == REQUEST_MOVE) {
+                // moves for the same game often come in a row, only reload
+                // the scratch game when another one is played
+                if (loaded != req.game.index) {
+                    scratch.load(s.game);
+                    loaded = req.game.index;
+                }
+                if (req.side == COLOR_NB || req.side == scratch.sideToMove()) {
+                    reply.result = scratch.applyMove(Square(req.from), Square(req.to), PieceType(req.promo));
+                }
+                if (reply.result != MOVE_ILLEGAL) {
+                    reply.move = scratch.lastMove();
+                    scratch.save(s.game);
+                }
+            }
+            reply.state = s.game;
+            if (req.type == REQUEST_CLOSE) {
+                if (loaded == req.game.index) {
+                    loaded = NoSlot;
+                }
+                release(req.game.index);
+            }
+            replies.push_back(reply);
+        }
+        done.fetch_add(batch.size(), memory_order_relaxed);
+        batch.clear();
+
+        if (onReplies) {
+            onReplies(replies);
+        }
+    }
+}
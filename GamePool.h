@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Game.h"
+
+// names one pooled game: the slot plus the slot's generation, so a handle
+// kept after its game closed never reaches a new game reusing the slot
+struct GameHandle {
+    uint32_t index;
+    uint32_t generation;
+};
+
+inline bool operator==(GameHandle a, GameHandle b) {
+    return a.index == b.index && a.generation == b.generation;
+}
+
+enum GameRequestType : uint8_t {
+    REQUEST_MOVE,   // play from -> to (promo for promotions)
+    REQUEST_QUERY,  // just report the current state
+    REQUEST_CLOSE   // end the game and free its slot
+};
+
+struct GameRequest {
+    GameHandle game;
+    GameRequestType type;
+    uint8_t from;
+    uint8_t to;
+    uint8_t promo;
+    uint8_t side;  // REQUEST_MOVE: only legal when this colour is to move, COLOR_NB = either
+    uint64_t tag;  // caller's cookie, handed back in the reply
+};
+
+struct GameReply {
+    GameHandle game;
+    GameRequestType type;
+    bool found;         // false: the handle is stale, nothing else is valid
+    MoveResult result;  // REQUEST_MOVE only
+    Move move;          // the move played, MOVE_NONE if it was illegal
+    uint64_t tag;
+    PackedGame state;   // the game after the request (Game::load() reads it)
+};
+
+// many games in one process. Each game is a 46-byte PackedGame in a slab of
+// 56-byte slots, reused through a free list. Requests are queued per
+// worker thread (a game always belongs to the same worker, so its requests
+// run in order and need no lock); a worker takes its whole queue per
+// wake-up, replays it against a scratch Game and hands all replies of the
+// batch to the reply handler at once, on the worker's thread.
+class GamePool {
+public:
+    typedef std::function<void(const std::vector<GameReply>&)> ReplyHandler;
+
+    GamePool(int workers, ReplyHandler onReplies);
+    ~GamePool();
+
+    GamePool(const GamePool&) = delete;
+    GamePool& operator=(const GamePool&) = delete;
+
+    // new game from fen (start position by default); false if the fen is
+    // invalid or the pool is full
+    bool create(GameHandle& handle, const std::string& fen = StartFEN);
+
+    // queue requests; a batch takes each worker's lock once
+    void submit(const GameRequest& req) { submit(&req, 1); }
+    void submit(const GameRequest* reqs, size_t count);
+
+    void submitMove(GameHandle g, Square from, Square to, PieceType promo, uint64_t tag = 0, Color side = COLOR_NB);
+    void close(GameHandle g, uint64_t tag = 0);
+
+    size_t liveGames() const { return live.load(std::memory_order_relaxed); }
+    size_t capacity() const { return (size_t)chunkCount * ChunkSize; }
+    uint64_t requestsDone() const { return done.load(std::memory_order_relaxed); }
+    int workerCount() const { return (int)workers.size(); }
+
+    // bytes of game state per slot, free-list link and generation included
+    static size_t slotBytes();
+
+private:
+    // generation is odd while a game lives in the slot; it is the only
+    // field a worker reads before it knows the handle is current, since
+    // create() may be refilling a slot a stale request still names
+    struct Slot {
+        PackedGame game;
+        std::atomic<uint32_t> generation;
+        uint32_t nextFree;  // free list link, under slabMutex
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::vector<GameRequest> queue;
+        bool quitting = false;
+        std::thread thread;
+    };
+
+    static const int ChunkBits = 12;
+    static const uint32_t ChunkSize = 1u << ChunkBits;
+    static const int MaxChunks = 4096;  // 16M games
+    static const uint32_t NoSlot = 0xFFFFFFFF;
+
+    Slot& slot(uint32_t index) { return chunks[index >> ChunkBits][index & (ChunkSize - 1)]; }
+    void work(Worker& w);
+    void release(uint32_t index);
+
+    ReplyHandler onReplies;
+    PackedGame startGame;
+
+    // slab: chunks are only added (under slabMutex) and never move, so a
+    // worker can reach a slot without the lock once a request names it
+    std::mutex slabMutex;
+    std::unique_ptr<Slot[]> chunks[MaxChunks];
+    int chunkCount;
+    uint32_t freeHead;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<size_t> live;
+    std::atomic<uint64_t> done;
+};
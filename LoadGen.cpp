@@ -0,0 +1,212 @@
+// load generator for the game server (Linux): plays thousands of random
+// games over loopback, each with one move in flight, and reports moves per
+// second and the round-trip latency of a move (send -> update received)
+//
+// usage: loadgen [--port N] [--connections N] [--games N] [--seconds S]
+//   --games N   games in play at once, spread over the connections
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "Game.h"
+
+using namespace std;
+typedef chrono::steady_clock Clock;
+
+const int MaxPlies = 200;  // a game is abandoned and replaced after this
+
+struct ClientGame {
+    Game game;
+    Move pending;
+    Clock::time_point sentAt;
+};
+
+struct ClientConn {
+    int fd;
+    string in;
+    string out;
+    unordered_map<uint64_t, unique_ptr<ClientGame>> games;
+};
+
+struct Stats {
+    uint64_t moves = 0;
+    uint64_t gamesFinished = 0;
+    uint64_t errors = 0;
+    uint64_t mismatches = 0;  // server board differs from ours
+    vector<uint32_t> latencyUs;
+};
+
+mt19937 rng(7);
+
+void sendMove(ClientConn& c, uint64_t id, ClientGame& g) {
+    const MoveList& moves = g.game.legalMoves();
+    g.pending = moves[rng() % moves.size()];
+    g.sentAt = Clock::now();
+    c.out += "move " + to_string(id) + " " + moveToString(g.pending) + "\n";
+}
+
+void handleLine(ClientConn& c, const string& line, Stats& stats, bool measuring) {
+    istringstream in(line);
+    string cmd, colour, text, result;
+    uint64_t id = 0;
+    in >> cmd >> id;
+
+    if (cmd == "game") {
+        unique_ptr<ClientGame> g(new ClientGame());
+        sendMove(c, id, *g);
+        c.games[id] = move(g);
+    }
+    else if (cmd == "update") {
+        auto it = c.games.find(id);
+        if (it == c.games.end()) {
+            stats.errors++;
+            return;
+        }
+        ClientGame& g = *it->second;
+        in >> text >> result;
+        string fen;
+        getline(in, fen);
+        if (measuring) {
+            stats.moves++;
+            stats.latencyUs.push_back((uint32_t)chrono::duration_cast<chrono::microseconds>(Clock::now() - g.sentAt).count());
+        }
+        g.game.applyMove(g.pending);
+        if (text != moveToString(g.pending) || fen.substr(1) != g.game.position().fen()) {
+            stats.mismatches++;
+        }
+        if (g.game.isOver() || g.game.position().gamePly() >= MaxPlies) {
+            stats.gamesFinished += g.game.isOver();
+            c.out += "close " + to_string(id) + "\nnew\n";
+            c.games.erase(it);
+        }
+        else {
+            sendMove(c, id, g);
+        }
+    }
+    else if (cmd == "closed") {
+        // already replaced
+    }
+    else {
+        stats.errors++;
+        if (stats.errors <= 5) {
+            cout << "server: " << line << endl;
+        }
+    }
+}
+
+bool flush(ClientConn& c) {
+    while (!c.out.empty()) {
+        ssize_t n = send(c.fd, c.out.data(), c.out.size(), MSG_NOSIGNAL);
+        if (n < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        c.out.erase(0, n);
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    initBitboards();
+    signal(SIGPIPE, SIG_IGN);
+
+    int port = 7777, connections = 50, games = 5000;
+    double seconds = 10;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string arg = argv[i];
+        if (arg == "--port") { port = atoi(argv[i + 1]); }
+        else if (arg == "--connections") { connections = max(1, atoi(argv[i + 1])); }
+        else if (arg == "--games") { games = max(1, atoi(argv[i + 1])); }
+        else if (arg == "--seconds") { seconds = atof(argv[i + 1]); }
+    }
+
+    int epollFd = epoll_create1(0);
+    vector<unique_ptr<ClientConn>> conns;
+    for (int i = 0; i < connections; i++) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(port);
+        if (connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+            cout << "cannot connect to port " << port << ": " << strerror(errno) << endl;
+            return 1;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        unique_ptr<ClientConn> c(new ClientConn());
+        c->fd = fd;
+        // this connection's share of the games
+        int share = games / connections + (i < games % connections);
+        for (int g = 0; g < share; g++) {
+            c->out += "new\n";
+        }
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.u32 = i;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+        conns.push_back(move(c));
+    }
+    for (auto& c : conns) {
+        flush(*c);
+    }
+
+    // the first second warms up (all games created), then we measure
+    Stats stats;
+    Clock::time_point start = Clock::now();
+    Clock::time_point measureFrom = start + chrono::seconds(1);
+    Clock::time_point end = measureFrom + chrono::microseconds((int64_t)(seconds * 1e6));
+    epoll_event events[256];
+    char buf[65536];
+    while (Clock::now() < end) {
+        int n = epoll_wait(epollFd, events, 256, 100);
+        bool measuring = Clock::now() >= measureFrom;
+        for (int i = 0; i < n; i++) {
+            ClientConn& c = *conns[events[i].data.u32];
+            ssize_t got = recv(c.fd, buf, sizeof(buf), 0);
+            if (got <= 0) {
+                cout << "server closed the connection" << endl;
+                return 1;
+            }
+            c.in.append(buf, got);
+            size_t pos = 0, nl;
+            while ((nl = c.in.find('\n', pos)) != string::npos) {
+                handleLine(c, c.in.substr(pos, nl - pos), stats, measuring);
+                pos = nl + 1;
+            }
+            c.in.erase(0, pos);
+            flush(c);
+        }
+    }
+
+    double secs = chrono::duration<double>(Clock::now() - measureFrom).count();
+    sort(stats.latencyUs.begin(), stats.latencyUs.end());
+    auto pct = [&](double p) {
+        return stats.latencyUs.empty() ? 0u : stats.latencyUs[min(stats.latencyUs.size() - 1, (size_t)(p * stats.latencyUs.size()))];
+    };
+    cout << connections << " connections, " << games << " games in flight" << endl;
+    cout << "moves: " << stats.moves << "  (" << (uint64_t)(stats.moves / secs) << " moves/s)" << endl;
+    cout << "latency us: p50 " << pct(0.50) << "  p99 " << pct(0.99) << "  max " << pct(1.0) << endl;
+    cout << "games finished: " << stats.gamesFinished << "  errors: " << stats.errors
+         << "  board mismatches: " << stats.mismatches << endl;
+
+    for (auto& c : conns) {
+        close(c->fd);
+    }
+    close(epollFd);
+    return stats.errors || stats.mismatches ? 1 : 0;
+}
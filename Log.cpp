@@ -0,0 +1,248 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include "Log.h"
+#include "Position.h"
+#include "SpscQueue.h"
+
+using namespace std;
+
+const int WriterPollMs = 5;  // how long the idle writer sleeps between looks at the ring
+
+static SpscQueue<LogRecord, 1024> records;
+static atomic<bool> running(false);
+static atomic<uint8_t> consoleLevel(LOG_INFO);
+static atomic<uint64_t> dropped(0);
+static FILE* eventFile = nullptr;
+static chrono::steady_clock::time_point startTime;
+static thread writer;
+
+static const char* pieceName(int pc) {
+    static const char* const Names[PIECE_NB] = {
+        "White Pawn", "White Knight", "White Bishop", "White Rook", "White Queen", "White King",
+        "Black Pawn", "Black Knight", "Black Bishop", "Black Rook", "Black Queen", "Black King"
+    };
+    return pc >= 0 && pc < PIECE_NB ? Names[pc] : "Empty";
+}
+
+static const char* colorName(int c) {
+    return c == WHITE ? "White" : "Black";
+}
+
+static const char* lowerColorName(int c) {
+    return c == WHITE ? "white" : "black";
+}
+
+// the console lines the window used to print with cout
+static void writeConsole(const LogRecord& r, string& text) {
+    switch (r.event) {
+    case EVENT_CLICK: {
+        Square s = Square(r.a);
+        printf("Clicked: %c%d (Row %d, Col %d)", 'a' + colOf(s), 8 - rowOf(s), rowOf(s), colOf(s));
+        if (r.b != NO_PIECE) {
+            printf(" -> %s", pieceName(r.b));
+        }
+        printf("\n");
+        break;
+    }
+    case EVENT_PROMOTION:
+        printf("Promoted to %s\n", pieceName(r.a));
+        break;
+    case EVENT_MOVE:
+        if (r.c) {
+            printf("Computer plays %s\n", moveToString(Move(r.a)).c_str());
+        }
+        printf("Move Valid. %s's turn.\n", colorName(r.b));
+        break;
+    case EVENT_ILLEGAL:
+        printf("Invalid Move!\n");
+        break;
+    case EVENT_CAPTURE:
+        printf("   CAPTURED! Took piece: %s (+%d)\n", pieceName(r.a), getPieceValue(Piece(r.a)));
+        printf("   SCORE -> White: %d | Black: %d\n", r.b, r.c);
+        break;
+    case EVENT_CHECK:
+        printf("CHECK!\n");
+        break;
+    case EVENT_CHECKMATE:
+        printf("%s Wins!\n%s Score: %d\n", colorName(r.a), colorName(r.a), r.a == WHITE ? r.b : r.c);
+        break;
+    case EVENT_STALEMATE:
+        printf("Draw!\nBlack Score: %d\n", r.c);
+        break;
+    case EVENT_TEXT:
+        text.append(r.text, r.length);
+        if (!r.more) {
+            printf("%s\n", text.c_str());
+            text.clear();
+        }
+        break;
+    }
+}
+
+// one JSON object per game event; clicks and text are not game events
+static void writeEvent(const LogRecord& r) {
+    double t = r.time / 1e9;
+    switch (r.event) {
+    case EVENT_PROMOTION:
+        fprintf(eventFile, "{\"t\":%.6f,\"event\":\"promotion\",\"piece\":\"%c\"}\n", t, pieceToChar(Piece(r.a)));
+        break;
+    case EVENT_MOVE:
+        fprintf(eventFile, "{\"t\":%.6f,\"event\":\"move\",\"move\":\"%s\",\"by\":\"%s\",\"turn\":\"%s\"}\n", t,
+                moveToString(Move(r.a)).c_str(), r.c ? "computer" : "player", lowerColorName(r.b));
+        break;
+    case EVENT_ILLEGAL:
+        fprintf(eventFile, "{\"t\":%.6f,\"event\":\"illegal\",\"from\":\"%s\",\"to\":\"%s\"}\n", t,
+                squareToString(Square(r.a)).c_str(), squareToString(Square(r.b)).c_str());
+        break;
+    case EVENT_CAPTURE:
+        fprintf(eventFile, "{\"t\":%.6f,\"event\":\"capture\",\"piece\":\"%c\",\"white\":%d,\"black\":%d}\n", t,
+                pieceToChar(Piece(r.a)), r.b, r.c);
+        break;
+    case EVENT_CHECK:
+        fprintf(eventFile, "{\"t\":%.6f,\"event\":\"check\",\"side\":\"%s\"}\n", t, lowerColorName(r.a));
+        break;
+    case EVENT_CHECKMATE:
+        fprintf(eventFile, "{\"t\":%.6f,\"event\":\"checkmate\",\"winner\":\"%s\",\"white\":%d,\"black\":%d}\n", t,
+                lowerColorName(r.a), r.b, r.c);
+        break;
+    case EVENT_STALEMATE:
+        fprintf(eventFile, "{\"t\":%.6f,\"event\":\"stalemate\",\"white\":%d,\"black\":%d}\n", t, r.b, r.c);
+        break;
+    default:
+        break;
+    }
+}
+
+// drains the ring and flushes once per batch instead of once per line
+static void writerLoop() {
+    string text;
+    uint64_t reported = 0;
+    while (true) {
+        // read before draining: everything logged before stopLog() is written
+        bool stopping = !running.load(memory_order_acquire);
+        LogRecord r;
+        int n = 0;
+        while (records.pop(r)) {
+            if (r.level >= consoleLevel.load(memory_order_relaxed)) {
+                writeConsole(r, text);
+            }
+            if (eventFile) {
+                writeEvent(r);
+            }
+            n++;
+        }
+        uint64_t lost = dropped.load(memory_order_relaxed);
+        if (lost != reported) {
+            printf("log: %llu records dropped\n", (unsigned long long)(lost - reported));
+            reported = lost;
+            n++;
+        }
+        if (n) {
+            fflush(stdout);
+            if (eventFile) {
+                fflush(eventFile);
+            }
+        }
+        if (stopping) {
+            return;
+        }
+        if (!n) {
+            this_thread::sleep_for(chrono::milliseconds(WriterPollMs));
+        }
+    }
+}
+
+bool startLog(LogLevel level, const string& events) {
+    if (running.load()) {
+        return true;
+    }
+    bool ok = true;
+    if (!events.empty()) {
+        eventFile = fopen(events.c_str(), "w");
+        if (!eventFile) {
+            printf("can't open event file %s\n", events.c_str());
+            ok = false;
+        }
+    }
+    consoleLevel.store(level);
+    startTime = chrono::steady_clock::now();
+    running.store(true, memory_order_release);
+    writer = thread(writerLoop);
+    return ok;
+}
+
+void stopLog() {
+    if (!running.exchange(false, memory_order_acq_rel)) {
+        return;
+    }
+    writer.join();
+    if (eventFile) {
+        fclose(eventFile);
+        eventFile = nullptr;
+    }
+}
+
+LogLevel parseLogLevel(const string& name, LogLevel fallback) {
+    if (name == "debug") { return LOG_DEBUG; }
+    if (name == "info") { return LOG_INFO; }
+    if (name == "warn") { return LOG_WARN; }
+    if (name == "error") { return LOG_ERROR; }
+    if (name == "off") { return LOG_OFF; }
+    return fallback;
+}
+
+// below the console level a record is only queued for the event stream
+static bool wanted(LogLevel level, LogEvent event) {
+    if (!running.load(memory_order_relaxed)) {
+        return false;
+    }
+    if (level >= consoleLevel.load(memory_order_relaxed)) {
+        return true;
+    }
+    return eventFile && event != EVENT_CLICK && event != EVENT_TEXT;
+}
+
+static void push(LogRecord& r) {
+    r.time = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - startTime).count();
+    if (!records.push(r)) {
+        dropped.fetch_add(1, memory_order_relaxed);
+    }
+}
+
+void logEvent(LogLevel level, LogEvent event, int32_t a, int32_t b, int32_t c) {
+    if (!wanted(level, event)) {
+        return;
+    }
+    LogRecord r;
+    r.level = level;
+    r.event = event;
+    r.more = 0;
+    r.length = 0;
+    r.a = a;
+    r.b = b;
+    r.c = c;
+    push(r);
+}
+
+void logText(LogLevel level, const char* text, size_t length) {
+    if (!wanted(level, EVENT_TEXT)) {
+        return;
+    }
+    LogRecord r;
+    r.level = level;
+    r.event = EVENT_TEXT;
+    r.a = r.b = r.c = 0;
+    do {
+        size_t n = min(length, sizeof(r.text));
+        memcpy(r.text, text, n);
+        r.length = uint8_t(n);
+        text += n;
+        length -= n;
+        r.more = length > 0;
+        push(r);
+    } while (length > 0);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// console log of the window. The thread that logs (the window's) only copies
+// a fixed-size record into a lock-free ring: no formatting, no allocation, no
+// write or flush. A background thread turns the records into the familiar
+// console lines and, if asked, into a machine-readable game event stream
+// (one JSON object per line). Records are dropped, and counted, when the
+// ring is full; the logging thread never waits for the console.
+//
+// Build flags: -DNO_LOG removes every LOG_ call, -DLOG_MIN_LEVEL=LOG_WARN
+// (say) removes the calls below that level.
+
+enum LogLevel : uint8_t {
+    LOG_DEBUG,
+    LOG_INFO,
+    LOG_WARN,
+    LOG_ERROR,
+    LOG_OFF
+};
+
+enum LogEvent : uint8_t {
+    EVENT_CLICK,      // a = square, b = piece on it
+    EVENT_PROMOTION,  // a = piece chosen
+    EVENT_MOVE,       // a = move, b = side to move after it, c = 1 if the computer played it
+    EVENT_ILLEGAL,    // a = from, b = to
+    EVENT_CAPTURE,    // a = piece taken, b = white score, c = black score
+    EVENT_CHECK,      // a = side in check
+    EVENT_CHECKMATE,  // a = winner, b = white score, c = black score
+    EVENT_STALEMATE,  // b = white score, c = black score
+    EVENT_TEXT        // free text (engine lines), split over several records
+};
+
+// one cache line per record
+struct LogRecord {
+    uint64_t time;     // ns since startLog()
+    LogLevel level;
+    LogEvent event;
+    uint8_t more;      // EVENT_TEXT: the text goes on in the next record
+    uint8_t length;    // EVENT_TEXT: bytes used in text
+    int32_t a, b, c;
+    char text[36];
+};
+
+static_assert(sizeof(LogRecord) == 64, "log records are one cache line");
+
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL LOG_DEBUG
+#endif
+
+// starts the writer thread; events: file for the game event stream, empty
+// for none. Returns false if the file can't be opened (logging still runs).
+bool startLog(LogLevel level, const std::string& events = "");
+// writes what is still queued and stops the writer
+void stopLog();
+LogLevel parseLogLevel(const std::string& name, LogLevel fallback);
+
+// one producer thread only; use the macros below
+void logEvent(LogLevel level, LogEvent event, int32_t a = 0, int32_t b = 0, int32_t c = 0);
+void logText(LogLevel level, const char* text, size_t length);
+
+#if defined(NO_LOG)
+#define LOG_EVENT(level, ...) ((void)0)
+#define LOG_TEXT(level, text, length) ((void)0)
+#else
+#define LOG_EVENT(level, ...) ((level) >= LOG_MIN_LEVEL ? logEvent((level), __VA_ARGS__) : (void)0)
+#define LOG_TEXT(level, text, length) ((level) >= LOG_MIN_LEVEL ? logText((level), (text), (length)) : (void)0)
+#endif
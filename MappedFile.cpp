@@ -0,0 +1,131 @@
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile() : ptr(nullptr), length(0), opened(false), file(nullptr), mapping(nullptr) {}
+
+bool MappedFile::open(const string& path) {
+    close();
+    HANDLE f = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                           FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (f == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER sz;
+    if (!GetFileSizeEx(f, &sz)) {
+        CloseHandle(f);
+        return false;
+    }
+    file = f;
+    length = (uint64_t)sz.QuadPart;
+    opened = true;
+    if (length == 0) {
+        return true;
+    }
+    mapping = CreateFileMappingA(f, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping) {
+        ptr = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    }
+    if (!ptr) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close() {
+    if (ptr) {
+        UnmapViewOfFile(ptr);
+    }
+    if (mapping) {
+        CloseHandle(mapping);
+    }
+    if (file) {
+        CloseHandle(file);
+    }
+    ptr = nullptr;
+    mapping = nullptr;
+    file = nullptr;
+    length = 0;
+    opened = false;
+}
+
+void MappedFile::adviseSequential() {}
+
+#else
+
+MappedFile::MappedFile() : ptr(nullptr), length(0), opened(false) {}
+
+bool MappedFile::open(const string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) { // pipes can't be mapped
+        ::close(fd);
+        return false;
+    }
+    length = (uint64_t)st.st_size;
+    if (length) {
+        void* mem = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mem == MAP_FAILED) {
+            ::close(fd);
+            length = 0;
+            return false;
+        }
+        ptr = (const char*)mem;
+    }
+    ::close(fd); // the mapping keeps the file open
+    opened = true;
+    return true;
+}
+
+void MappedFile::close() {
+    if (ptr) {
+        munmap((void*)ptr, length);
+    }
+    ptr = nullptr;
+    length = 0;
+    opened = false;
+}
+
+void MappedFile::adviseSequential() {
+    if (ptr) {
+        madvise((void*)ptr, length, MADV_SEQUENTIAL);
+    }
+}
+
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+int seekFile(FILE* f, uint64_t offset, int whence) {
+#if defined(_WIN32)
+    return _fseeki64(f, (long long)offset, whence);
+#else
+    return fseeko(f, (off_t)offset, whence);
+#endif
+}
+
+uint64_t tellFile(FILE* f) {
+#if defined(_WIN32)
+    return (uint64_t)_ftelli64(f);
+#else
+    return (uint64_t)ftello(f);
+#endif
+}
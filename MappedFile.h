@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// read-only view of a whole file, mapped into memory (mmap, or a file
+// mapping on Windows) so big files are paged in by the OS instead of read
+// into buffers. An empty file opens with size 0 and no data.
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // false if the file can't be opened or mapped
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return opened; }
+    const char* data() const { return ptr; }
+    uint64_t size() const { return length; }
+
+    // hint that the data will be read front to back (no-op where unsupported)
+    void adviseSequential();
+
+private:
+    const char* ptr;
+    uint64_t length;
+    bool opened;
+#if defined(_WIN32)
+    void* file;
+    void* mapping;
+#endif
+};
+
+// 64-bit file offsets for stdio on every platform
+int seekFile(FILE* f, uint64_t offset, int whence);
+uint64_t tellFile(FILE* f);
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+#include "Bitboard.h"
+
+// MOVE ENCODING (16 bits)
+// bits 0-5 from square, 6-11 to square, 12-13 promotion piece (knight..queen),
+// 14-15 move type
+typedef uint16_t Move;
+
+const Move MOVE_NONE = 0;
+
+enum MoveType {
+    NORMAL = 0,
+    PROMOTION = 1 << 14,
+    EN_PASSANT = 2 << 14,
+    CASTLING = 3 << 14
+};
+
+inline Move encodeMove(Square from, Square to, MoveType type = NORMAL, PieceType promo = KNIGHT) {
+    return Move(from | (to << 6) | ((promo - KNIGHT) << 12) | type);
+}
+
+inline Square fromSq(Move m) { return m & 0x3F; }
+inline Square toSq(Move m) { return (m >> 6) & 0x3F; }
+inline MoveType typeOfMove(Move m) { return MoveType(m & (3 << 14)); }
+inline PieceType promotionType(Move m) { return PieceType(((m >> 12) & 3) + KNIGHT); }
+
+// coordinate notation, e.g. "e2e4" or "e7e8q"
+std::string moveToString(Move m);
+std::string squareToString(Square s);
+
+// fixed capacity move buffer, lives on the stack
+const int MAX_MOVES = 256;
+
+struct MoveList {
+    Move moves[MAX_MOVES];
+    int count = 0;
+
+    void add(Move m) { moves[count++] = m; }
+    int size() const { return count; }
+    void clear() { count = 0; }
+    Move operator[](int i) const { return moves[i]; }
+    const Move* begin() const { return moves; }
+    const Move* end() const { return moves + count; }
+    bool contains(Move m) const {
+        for (int i = 0; i < count; i++) {
+            if (moves[i] == m) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
@@ -0,0 +1,396 @@
+#include "MoveGen.h"
+
+using namespace std;
+
+string squareToString(Square s) {
+    string str = "";
+    str += (char)('a' + fileOf(s));
+    str += (char)('1' + rankOf(s));
+    return str;
+}
+
+string moveToString(Move m) {
+    if (m == MOVE_NONE) {
+        return "0000";
+    }
+    string str = squareToString(fromSq(m)) + squareToString(toSq(m));
+    if (typeOfMove(m) == PROMOTION) {
+        str += "nbrq"[promotionType(m) - KNIGHT];
+    }
+    return str;
+}
+
+namespace {
+
+// one entry per promotion piece, queen first; queen only for capture lists
+void addPromotions(MoveList& list, Square from, Square to, bool capturesOnly) {
+    list.add(encodeMove(from, to, PROMOTION, QUEEN));
+    if (capturesOnly) {
+        return;
+    }
+    list.add(encodeMove(from, to, PROMOTION, ROOK));
+    list.add(encodeMove(from, to, PROMOTION, BISHOP));
+    list.add(encodeMove(from, to, PROMOTION, KNIGHT));
+}
+
+// pawn moves landing on target; pinned pawns stay on their pin line.
+// capturesOnly keeps captures, en passant and promotions
+void generatePawnMoves(const Position& pos, MoveList& list, Bitboard target, bool capturesOnly) {
+    Color us = pos.sideToMove();
+    Color them = ~us;
+    Square ksq = pos.kingSquare(us);
+    int up = (us == WHITE) ? 8 : -8;
+    int lastRank = (us == WHITE) ? 7 : 0;
+    int startRank = (us == WHITE) ? 1 : 6;
+    Bitboard empty = ~pos.pieces();
+
+    Bitboard pawns = pos.pieces(us, PAWN);
+    while (pawns) {
+        Square from = popLsb(pawns);
+        Bitboard allowed = target;
+        if (pos.pinned() & squareBB(from)) {
+            allowed &= lineBB(ksq, from);
+        }
+
+        // pushes
+        Square one = from + up;
+        if (empty & squareBB(one)) {
+            if (allowed & squareBB(one)) {
+                if (rankOf(one) == lastRank) {
+                    addPromotions(list, from, one, capturesOnly);
+                }
+                else if (!capturesOnly) {
+                    list.add(encodeMove(from, one));
+                }
+            }
+            Square two = one + up;
+            if (!capturesOnly && rankOf(from) == startRank && (empty & allowed & squareBB(two))) {
+                list.add(encodeMove(from, two));
+            }
+        }
+
+        // captures
+        Bitboard caps = PawnAttacks[us][from] & pos.pieces(them) & allowed;
+        while (caps) {
+            Square to = popLsb(caps);
+            if (rankOf(to) == lastRank) {
+                addPromotions(list, from, to, capturesOnly);
+            }
+            else {
+                list.add(encodeMove(from, to));
+            }
+        }
+
+        // en passant removes two pieces from the capture rank, so test the
+        // resulting occupancy directly instead of trusting pin/check masks
+        Square ep = pos.epSquare();
+        if (ep != NO_SQUARE && (PawnAttacks[us][from] & squareBB(ep))) {
+            Square capSq = ep - up;
+            Bitboard occ = (pos.pieces() ^ squareBB(from) ^ squareBB(capSq)) | squareBB(ep);
+            if (!(pos.attackersTo(ksq, occ) & pos.pieces(them) & ~squareBB(capSq))) {
+                list.add(encodeMove(from, ep, EN_PASSANT));
+            }
+        }
+    }
+}
+
+// knight, bishop, rook and queen moves landing on target
+void generatePieceMoves(const Position& pos, MoveList& list, Bitboard target) {
+    Color us = pos.sideToMove();
+    Square ksq = pos.kingSquare(us);
+
+    for (int pt = KNIGHT; pt <= QUEEN; pt++) {
+        Bitboard pcs = pos.pieces(us, PieceType(pt));
+        while (pcs) {
+            Square from = popLsb(pcs);
+            Bitboard att = attacksBB(PieceType(pt), from, pos.pieces()) & target;
+            if (pos.pinned() & squareBB(from)) {
+                att &= lineBB(ksq, from);
+            }
+            while (att) {
+                list.add(encodeMove(from, popLsb(att)));
+            }
+        }
+    }
+}
+
+// every square attacked by c; occ lets the caller remove our king so it
+// cannot hide behind itself on a slider ray
+Bitboard attackedSquares(const Position& pos, Color c, Bitboard occ) {
+    Bitboard attacked = 0;
+    Bitboard pawns = pos.pieces(c, PAWN);
+    while (pawns) {
+        attacked |= PawnAttacks[c][popLsb(pawns)];
+    }
+    for (int pt = KNIGHT; pt <= KING; pt++) {
+        Bitboard pcs = pos.pieces(c, PieceType(pt));
+        while (pcs) {
+            attacked |= attacksBB(PieceType(pt), popLsb(pcs), occ);
+        }
+    }
+    return attacked;
+}
+
+void generateKingMoves(const Position& pos, MoveList& list, Bitboard attacked, bool capturesOnly) {
+    Color us = pos.sideToMove();
+    Square k = pos.kingSquare(us);
+
+    Bitboard att = KingAttacks[k] & (capturesOnly ? pos.pieces(~us) : ~pos.pieces(us)) & ~attacked;
+    while (att) {
+        list.add(encodeMove(k, popLsb(att)));
+    }
+    if (capturesOnly) {
+        return;
+    }
+
+    // castling: not out of, through or into check
+    int rights = pos.castlingRights() & (us == WHITE ? (WHITE_OO | WHITE_OOO) : (BLACK_OO | BLACK_OOO));
+    if (!rights || pos.inCheck()) {
+        return;
+    }
+    if ((rights & (WHITE_OO | BLACK_OO))
+        && !(betweenBB(k, k + 3) & pos.pieces())
+        && !(betweenBB(k, k + 3) & attacked)) {
+        list.add(encodeMove(k, k + 2, CASTLING));
+    }
+    if ((rights & (WHITE_OOO | BLACK_OOO))
+        && !(betweenBB(k, k - 4) & pos.pieces())
+        && !((squareBB(k - 1) | squareBB(k - 2)) & attacked)) {
+        list.add(encodeMove(k, k - 2, CASTLING));
+    }
+}
+
+void generate(Position& pos, MoveList& list, bool capturesOnly) {
+    Color us = pos.sideToMove();
+    Square ksq = pos.kingSquare(us);
+    Bitboard checkers = pos.checkers();
+
+    // king moves are tested against the enemy attack map
+    Bitboard attacked = attackedSquares(pos, ~us, pos.pieces() ^ squareBB(ksq));
+    generateKingMoves(pos, list, attacked, capturesOnly);
+
+    // double check: only the king can move
+    if (moreThanOne(checkers)) {
+        return;
+    }
+
+    // single check: capture the checker or block its ray
+    Bitboard target = capturesOnly ? pos.pieces(~us) : ~pos.pieces(us);
+    if (checkers) {
+        target &= betweenBB(ksq, lsb(checkers)) | checkers;
+    }
+
+    // pawns get the full target so promotion pushes survive in capture mode
+    Bitboard pawnTarget = checkers ? (betweenBB(ksq, lsb(checkers)) | checkers) : ~pos.pieces(us);
+    generatePawnMoves(pos, list, pawnTarget, capturesOnly);
+    generatePieceMoves(pos, list, target);
+}
+
+} // namespace
+
+void generateLegalMoves(Position& pos, MoveList& list) {
+    generate(pos, list, false);
+}
+
+void generateLegalCaptures(Position& pos, MoveList& list) {
+    generate(pos, list, true);
+}
+
+Move findLegalMove(Position& pos, Square from, Square to, PieceType promo) {
+    MoveList moves;
+    generateLegalMoves(pos, moves);
+    for (Move m : moves) {
+        if (fromSq(m) == from && toSq(m) == to
+            && (typeOfMove(m) != PROMOTION || promotionType(m) == promo)) {
+            return m;
+        }
+    }
+    return MOVE_NONE;
+}
+
+Move parseMove(Position& pos, const string& str) {
+    if (str.size() < 4 || str.size() > 5
+        || str[0] < 'a' || str[0] > 'h' || str[1] < '1' || str[1] > '8'
+        || str[2] < 'a' || str[2] > 'h' || str[3] < '1' || str[3] > '8') {
+        return MOVE_NONE;
+    }
+    Square from = makeSquare(str[0] - 'a', str[1] - '1');
+    Square to = makeSquare(str[2] - 'a', str[3] - '1');
+    PieceType promo = QUEEN;
+    if (str.size() == 5) {
+        switch (str[4]) {
+        case 'n': promo = KNIGHT; break;
+        case 'b': promo = BISHOP; break;
+        case 'r': promo = ROOK; break;
+        case 'q': promo = QUEEN; break;
+        default: return MOVE_NONE;
+        }
+    }
+    Move m = findLegalMove(pos, from, to, promo);
+    // a promotion needs its piece letter, a normal move must not have one
+    if (m != MOVE_NONE && (typeOfMove(m) == PROMOTION) != (str.size() == 5)) {
+        return MOVE_NONE;
+    }
+    return m;
+}
+
+static PieceType sanPieceType(char c) {
+    switch (c) {
+    case 'N': return KNIGHT;
+    case 'B': return BISHOP;
+    case 'R': return ROOK;
+    case 'Q': return QUEEN;
+    case 'K': return KING;
+    default: return PIECE_TYPE_NB;
+    }
+}
+
+Move parseSan(Position& pos, const char* san, size_t length) {
+    // suffixes: check, mate, annotations
+    while (length && (san[length - 1] == '+' || san[length - 1] == '#'
+                      || san[length - 1] == '!' || san[length - 1] == '?')) {
+        length--;
+    }
+    if (length < 2) {
+        return MOVE_NONE;
+    }
+
+    MoveList moves;
+    generateLegalMoves(pos, moves);
+
+    // castling, with letter O or digit zero
+    if (san[0] == 'O' || san[0] == '0') {
+        bool queenSide;
+        if (length == 3 && san[1] == '-' && san[2] == san[0]) {
+            queenSide = false;
+        }
+        else if (length == 5 && san[1] == '-' && san[2] == san[0] && san[3] == '-' && san[4] == san[0]) {
+            queenSide = true;
+        }
+        else {
+            return MOVE_NONE;
+        }
+        for (Move m : moves) {
+            if (typeOfMove(m) == CASTLING && (toSq(m) < fromSq(m)) == queenSide) {
+                return m;
+            }
+        }
+        return MOVE_NONE;
+    }
+
+    PieceType pt = sanPieceType(san[0]);
+    size_t i = 0;
+    if (pt == PIECE_TYPE_NB) {
+        pt = PAWN;
+    }
+    else {
+        i = 1;
+    }
+
+    // promotion piece, "=Q" or a bare "Q" after the square
+    PieceType promo = PIECE_TYPE_NB;
+    size_t end = length;
+    if (pt == PAWN && end >= 1 && sanPieceType(san[end - 1]) != PIECE_TYPE_NB) {
+        promo = sanPieceType(san[end - 1]);
+        end -= end >= 2 && san[end - 2] == '=' ? 2 : 1;
+    }
+
+    // destination square, then whatever disambiguates the origin
+    if (end < i + 2) {
+        return MOVE_NONE;
+    }
+    char tf = san[end - 2], tr = san[end - 1];
+    if (tf < 'a' || tf > 'h' || tr < '1' || tr > '8') {
+        return MOVE_NONE;
+    }
+    Square to = makeSquare(tf - 'a', tr - '1');
+    int fromFile = -1, fromRank = -1;
+    for (size_t j = i; j < end - 2; j++) {
+        char c = san[j];
+        if (c >= 'a' && c <= 'h') {
+            fromFile = c - 'a';
+        }
+        else if (c >= '1' && c <= '8') {
+            fromRank = c - '1';
+        }
+        else if (c != 'x' && c != '-' && c != ':') {
+            return MOVE_NONE;
+        }
+    }
+
+    Move found = MOVE_NONE;
+    for (Move m : moves) {
+        Square from = fromSq(m);
+        if (toSq(m) != to || typeOf(pos.pieceOn(from)) != pt
+            || (fromFile >= 0 && fileOf(from) != fromFile) || (fromRank >= 0 && rankOf(from) != fromRank)) {
+            continue;
+        }
+        if (typeOfMove(m) == CASTLING) {
+            continue; // only as O-O / O-O-O
+        }
+        if ((typeOfMove(m) == PROMOTION) != (promo != PIECE_TYPE_NB)
+            || (promo != PIECE_TYPE_NB && promotionType(m) != promo)) {
+            continue;
+        }
+        if (found != MOVE_NONE) {
+            return MOVE_NONE; // ambiguous
+        }
+        found = m;
+    }
+    return found;
+}
+
+string moveToSan(Position& pos, Move m) {
+    Square from = fromSq(m), to = toSq(m);
+    PieceType pt = typeOf(pos.pieceOn(from));
+    string san = "";
+
+    if (typeOfMove(m) == CASTLING) {
+        san = to > from ? "O-O" : "O-O-O";
+    }
+    else {
+        bool capture = pos.capturedBy(m) != NO_PIECE;
+        if (pt == PAWN) {
+            if (capture) {
+                san += char('a' + fileOf(from));
+            }
+        }
+        else {
+            san += "PNBRQK"[pt];
+            // other pieces of the same kind that can reach the square
+            MoveList moves;
+            generateLegalMoves(pos, moves);
+            bool clash = false, sameFile = false, sameRank = false;
+            for (Move o : moves) {
+                if (o != m && toSq(o) == to && typeOf(pos.pieceOn(fromSq(o))) == pt) {
+                    clash = true;
+                    sameFile |= fileOf(fromSq(o)) == fileOf(from);
+                    sameRank |= rankOf(fromSq(o)) == rankOf(from);
+                }
+            }
+            if (clash && (!sameFile || sameRank)) {
+                san += char('a' + fileOf(from));
+            }
+            if (clash && sameFile) {
+                san += char('1' + rankOf(from));
+            }
+        }
+        if (capture) {
+            san += 'x';
+        }
+        san += squareToString(to);
+        if (typeOfMove(m) == PROMOTION) {
+            san += '=';
+            san += "PNBRQK"[promotionType(m)];
+        }
+    }
+
+    pos.makeMove(m);
+    if (pos.inCheck()) {
+        MoveList replies;
+        generateLegalMoves(pos, replies);
+        san += replies.size() ? '+' : '#';
+    }
+    pos.unmakeMove();
+    return san;
+}
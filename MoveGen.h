@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include "Move.h"
+#include "Position.h"
+
+// all legal moves for the side to move, appended to list
+void generateLegalMoves(Position& pos, MoveList& list);
+
+// legal captures, en passant and queen promotions only (for quiescence)
+void generateLegalCaptures(Position& pos, MoveList& list);
+
+// find the legal move going from -> to, MOVE_NONE if there is none;
+// promotions pick promo (queen by default)
+Move findLegalMove(Position& pos, Square from, Square to, PieceType promo = QUEEN);
+
+// legal move from coordinate notation ("e2e4", "e7e8q", castling as the king
+// move "e1g1"), MOVE_NONE if malformed or illegal
+Move parseMove(Position& pos, const std::string& str);
+
+// legal move from standard algebraic notation ("Nbd7", "exd6", "e8=Q+",
+// "O-O-O"); check, mate and annotation suffixes are ignored and long
+// algebraic ("Ng1-f3") is accepted. MOVE_NONE if malformed, illegal or
+// ambiguous. No allocation, for bulk PGN import.
+Move parseSan(Position& pos, const char* san, size_t length);
+
+// SAN of a legal move with the disambiguation it needs and + / # suffix
+std::string moveToSan(Position& pos, Move m);
@@ -1,479 +1,128 @@
 #include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
 #include <string>
+#include <vector>
+#include "AnalysisWorker.h"
+#include "BoardRenderer.h"
+#include "Game.h"
+#include "Log.h"
+#include "SearchPool.h"
+#include "Uci.h"
 
 using namespace std;
 
-// GLOBAL VARIABLES 
+// all game state lives in the Game object created in main(); this file is
+// only the SFML client drawing it and feeding it mouse input
 const int SIZE = 8;
-char board[SIZE][SIZE];
-bool whiteTurn = true;
-bool gameOver = false;
-bool isKingInCheck = false; // NEW: Track check state
-int whiteScore = 0;
-int blackScore = 0;
-string statusMsg = "";
+const int MaxFps = 60; // frame cap, only reached while a piece is dragged
+const int WorkerPollMs = 10; // how often results are picked up while the worker is busy
 
 // FUNCTION PROTOTYPES 
-// piece validation
-bool isValidPawnMove(int sx, int sy, int dx, int dy);
-bool isValidBishopMove(int sx, int sy, int dx, int dy);
-bool isValidRookMove(int sx, int sy, int dx, int dy);
-bool isValidKnightMove(int sx, int sy, int dx, int dy);
-bool isValidQueenMove(int sx, int sy, int dx, int dy);
-bool isValidKingMove(int sx, int sy, int dx, int dy);
-
-// Game Rule Prototypes
-bool isCheck(bool whiteKing);
-bool isCheckmate(bool whiteKing);
-bool isStalemate(bool whiteKing);
-
-// manager function
-bool isValidMove(int sx, int sy, int dx, int dy);
-
 // helper functions
-void Capture_func(char capturedPiece);
-void initializeBoard();
-string getPieceName(char p);
-int getTextureID(char p);
 void resizeView(const sf::Window& window, sf::View& view);
-void handlePromotion(int r, int c, sf::RenderWindow& window, const sf::Texture* textures, const float size);
-int getPieceValue(char p);
-void findKing(bool whiteKing, int& kr, int& kc);
-
-// PIECE LOGIC FUNCTIONS 
-
-// rook logic: straight lines
-bool isValidRookMove(int sx, int sy, int dx, int dy) {
-    // check straight line
-    if (sx != dx && sy != dy) {
-        return false;
-    }
-
-    // check vertical path
-    if (sy == dy) {
-        int step = (dx > sx) ? 1 : -1;
-        for (int r = sx + step; r != dx; r += step) {
-            if (board[r][sy] != ' ') {
-                return false; // blocked
-            }
-        }
-    }
-    // check horizontal path
-    else {
-        int step = (dy > sy) ? 1 : -1;
-        for (int c = sy + step; c != dy; c += step) {
-            if (board[sx][c] != ' ') {
-                return false; // blocked
-            }
-        }
-    }
-    return true;
-}
-
-// knight logic: L-shape jump
-bool isValidKnightMove(int sx, int sy, int dx, int dy) {
-    int rdiff = (dx > sx) ? dx - sx : sx - dx;
-    int cdiff = (dy > sy) ? dy - sy : sy - dy;
-
-    // check L-shape 
-    if ((rdiff == 2 && cdiff == 1) || (rdiff == 1 && cdiff == 2)) {
-        return true;
-    }
-    return false;
-}
-
-// bishop logic: diagonal lines
-bool isValidBishopMove(int sx, int sy, int dx, int dy) {
-
-    int rowdiff = dx - sx;
-    int coldiff = dy - sy;
-
-    int absrowdiff = (rowdiff > 0) ? rowdiff : -rowdiff; // absolute values to check equality of difference
-    int abscoldiff = (coldiff > 0) ? coldiff : -coldiff;
-
-    if (absrowdiff != abscoldiff)
-    {
-        return false; // not a diagonal move
-    }
-
-    int rowstep, colstep;
-
-    if (rowdiff > 0) { // 1 for down and right ,-1 for up and left
-        rowstep = 1;
-    }
-    else
-        rowstep = -1;
+void reportMove(const Game& game, MoveResult result, bool byEngine, string& statusMsg);
+int runAnalysis(const string& fen, SearchLimits limits, const EngineOptions& opts);
 
-    if (coldiff > 0) {
-        colstep = 1;
-    }
-    else
-        colstep = -1;
-
-    int r = sx + rowstep;
-    int c = sy + colstep;
-
-    while (r != dx && c != dy) { // while destination reaches
-        if (board[r][c] != ' ') {//path is bloacked
-            return false;
-        }
-        r += rowstep;
-        c += colstep;
-    }
-    return true;
-}
-
-
-// queen logic: rook + bishop
-bool isValidQueenMove(int sx, int sy, int dx, int dy) {
-    if (isValidRookMove(sx, sy, dx, dy)) {
-        return true;
-    }
-    if (isValidBishopMove(sx, sy, dx, dy)) {
-        return true;
-    }
-    return false;
-}
+// HELPER FUNCTIONS FOR SFML
 
-// king logic: 1 step any direction
-bool isValidKingMove(int sx, int sy, int dx, int dy) {
-    int rdiff = (dx > sx) ? dx - sx : sx - dx;
-    int cdiff = (dy > sy) ? dy - sy : sy - dy;
+// log a played move, fills statusMsg when the game ends
+void reportMove(const Game& game, MoveResult result, bool byEngine, string& statusMsg) {
+    LOG_EVENT(LOG_INFO, EVENT_MOVE, game.lastMove(), game.sideToMove(), byEngine);
 
-    if (rdiff <= 1 && cdiff <= 1) {
-        return true;
+    // check capture
+    if (game.lastCaptured() != NO_PIECE) {
+        LOG_EVENT(LOG_INFO, EVENT_CAPTURE, game.lastCaptured(), game.score(WHITE), game.score(BLACK));
     }
-    return false;
-}
 
-// pawn logic: forward and capture
-bool isValidPawnMove(int sx, int sy, int dx, int dy) {
-    char piece = board[sx][sy];
-    char dest = board[dx][dy];
+    bool whiteTurn = game.sideToMove() == WHITE;
 
-    if (piece == 'P') { // white pawn
-        if (sy == dy && dx == sx - 1 && dest == ' ') {
-            return true;
+    // check game over conditions
+    if (result == MOVE_CHECKMATE) {
+        statusMsg = (whiteTurn ? "Black" : "White");
+        statusMsg += " Wins!";
+        if (whiteTurn) { // Black Won
+            statusMsg += "\nBlack Score: " + to_string(game.score(BLACK));
         }
-        if (sx == 6 && sy == dy && dx == sx - 2 && dest == ' ' && board[sx - 1][sy] == ' ') {
-            return true;
+        else { // White Won
+            statusMsg += "\nWhite Score: " + to_string(game.score(WHITE));
         }
-        if (dx == sx - 1 && (dy == sy - 1 || dy == sy + 1) && (dest >= 'a' && dest <= 'z')) {
-            return true;
-        }
-    }
-    else if (piece == 'p') { // black pawn
-        if (sy == dy && dx == sx + 1 && dest == ' ') {
-            return true;
-        }
-        if (sx == 1 && sy == dy && dx == sx + 2 && dest == ' ' && board[sx + 1][sy] == ' ') {
-            return true;
-        }
-        if (dx == sx + 1 && (dy == sy - 1 || dy == sy + 1) && (dest >= 'A' && dest <= 'Z')) {
-            return true;
-        }
-    }
-    return false;
-}
-
-// checks turns and calls helpers
-bool isValidMove(int sx, int sy, int dx, int dy) {
-    char piece = board[sx][sy];
-    char dest = board[dx][dy];
-
-    if (piece == ' ') {
-        return false;
-    }
-
-    // check turns
-    if (whiteTurn && (piece >= 'a' && piece <= 'z')) {
-        return false;
-    }
-    if (!whiteTurn && (piece >= 'A' && piece <= 'Z')) {
-        return false;
+        LOG_EVENT(LOG_INFO, EVENT_CHECKMATE, whiteTurn ? BLACK : WHITE, game.score(WHITE), game.score(BLACK));
     }
-
-    // check friendly fire
-    if (whiteTurn && (dest >= 'A' && dest <= 'Z')) {
-        return false;
-    }
-    if (!whiteTurn && (dest >= 'a' && dest <= 'z')) {
-        return false;
-    }
-
-    char p = (piece >= 'A' && piece <= 'Z') ? piece + 32 : piece;
-
-    if (p == 'p') {
-        return isValidPawnMove(sx, sy, dx, dy);
-    }
-    if (p == 'b') {
-        return isValidBishopMove(sx, sy, dx, dy);
-    }
-    if (p == 'r') {
-        return isValidRookMove(sx, sy, dx, dy);
-    }
-    if (p == 'n') {
-        return isValidKnightMove(sx, sy, dx, dy);
-    }
-    if (p == 'q') {
-        return isValidQueenMove(sx, sy, dx, dy);
-    }
-    if (p == 'k') {
-        return isValidKingMove(sx, sy, dx, dy);
-    }
-
-    return false;
-}
-
-//  to find king location of white or black player
-void findKing(bool whiteKing, int& kr, int& kc) { //for check/checkmate detection
-  
-    char target = 0;
-    if (whiteKing) { target = 'K'; }
-    else { target = 'k'; }
-
-    for (int r = 0; r < 8; r++) {
-        for (int c = 0; c < 8; c++) {
-            if (board[r][c] == target) {
-                kr = r; kc = c;
-                return;
-            }
-        }
+    else if (result == MOVE_STALEMATE) {
+        statusMsg = "Draw!";
+        statusMsg += "\nBlack Score: " + to_string(game.score(BLACK));
+        LOG_EVENT(LOG_INFO, EVENT_STALEMATE, 0, game.score(WHITE), game.score(BLACK));
     }
-}
-
-// check if king is under attack
-bool isCheck(bool whiteKing) {
-    int kr = -1;
-    int kc = -1;
-    findKing(whiteKing, kr, kc);
-
-    for (int r = 0; r < 8; r++) {
-        for (int c = 0; c < 8; c++) {
-            char p = board[r][c];
-            if (p != ' ') {
-                bool isWhitePiece = (p >= 'A' && p <= 'Z');
-                if (isWhitePiece != whiteKing) {
-
-                    char raw = (p >= 'A' && p <= 'Z') ? p + 32 : p;
-                    bool hit = false;
-
-                    if (raw == 'p') { hit = isValidPawnMove(r, c, kr, kc); }
-                    else if (raw == 'b') { hit = isValidBishopMove(r, c, kr, kc); }
-                    else if (raw == 'r') { hit = isValidRookMove(r, c, kr, kc); }
-                    else if (raw == 'n') { hit = isValidKnightMove(r, c, kr, kc); }
-                    else if (raw == 'q') { hit = isValidQueenMove(r, c, kr, kc); }
-                    else if (raw == 'k') { hit = isValidKingMove(r, c, kr, kc); }
-
-                    if (hit) {
-                        return true;
-                    }
-                }
-            }
-        }
+    else if (result == MOVE_CHECK) {
+        LOG_EVENT(LOG_INFO, EVENT_CHECK, game.sideToMove());
     }
-    return false;
 }
 
-// checkmate detection
-bool isCheckmate(bool whiteKing) {
-    if (!isCheck(whiteKing)) {
-        return false;
-    }
-
-    for (int sr = 0; sr < 8; sr++) {
-        for (int sc = 0; sc < 8; sc++) {
-            char p = board[sr][sc];
-            if (p != ' ') {
-                bool isWhite = (p >= 'A' && p <= 'Z');
-                if (isWhite == whiteKing) {
-                    for (int dr = 0; dr < 8; dr++) {
-                        for (int dc = 0; dc < 8; dc++) {
-                            if (isValidMove(sr, sc, dr, dc)) {
-                                // simulate move
-                                char temp = board[dr][dc];
-                                board[dr][dc] = board[sr][sc];
-                                board[sr][sc] = ' ';
-
-                                bool safe = !isCheck(whiteKing);
-
-                                // undo move
-                                board[sr][sc] = board[dr][dc];
-                                board[dr][dc] = temp;
-
-                                if (safe) {
-                                    return false; // found a save
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-        }
-    }
-    return true; // no moves left
+// analysis mode: search fen without opening a window, print every iteration
+int runAnalysis(const string& fen, SearchLimits limits, const EngineOptions& opts) {
+    Position pos;
+    if (!pos.setFen(fen)) {
+        cout << "invalid fen: " << fen << endl;
+        return 1;
+    }
+    TranspositionTable tt;
+    tt.resize(opts.hashMb);
+    SearchPool search(tt, opts.threads);
+    search.setUseNnue(setupNnue(opts));
+    SearchResult result = search.think(pos, limits, [](const SearchInfo& info) {
+        cout << formatInfo(info) << endl;
+    });
+    cout << "info string pawn hash hit rate " << (int)(search.pawnHashHitRate() * 1000) / 10.0 << "%" << endl;
+    cout << "bestmove " << moveToString(result.bestMove) << endl;
+    return 0;
 }
 
-// stalemate detection
-bool isStalemate(bool whiteKing) {
-    if (isCheck(whiteKing)) {
-        return false;
-    }
-
-    for (int sr = 0; sr < 8; sr++) {
-        for (int sc = 0; sc < 8; sc++) {
-            char p = board[sr][sc];
-            if (p != ' ') {
-                bool isWhite = (p >= 'A' && p <= 'Z');
-                if (isWhite == whiteKing) {
-                    for (int dr = 0; dr < 8; dr++) {
-                        for (int dc = 0; dc < 8; dc++) {
-                            if (isValidMove(sr, sc, dr, dc)) {
-                                char temp = board[dr][dc];
-                                board[dr][dc] = board[sr][sc];
-                                board[sr][sc] = ' ';
-
-                                bool check = isCheck(whiteKing);
-
-                                board[sr][sc] = board[dr][dc];
-                                board[dr][dc] = temp;
-
-                                if (!check) {
-                                    return false; // valid move exists
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-        }
+// pawn promotion waiting for the player's choice; the move is held until
+// a piece is clicked, the main loop keeps drawing and handling events
+struct PromotionChooser {
+    bool active = false;
+    Square from = NO_SQUARE;
+    Square to = NO_SQUARE;
+    sf::Vector2f topLeft;  // menu box, four squares wide
+    Piece choices[4];
+};
+
+// show the menu over the promotion square: Q, R, B, N
+void openPromotion(PromotionChooser& chooser, Square from, Square to, Color us, float size) {
+    chooser.active = true;
+    chooser.from = from;
+    chooser.to = to;
+    PieceType types[4] = { QUEEN, ROOK, BISHOP, KNIGHT };
+    for (int i = 0; i < 4; i++) {
+        chooser.choices[i] = makePiece(us, types[i]);
     }
-    return true; // no legal moves
+    // center over pawn, keep inside screen
+    float x = colOf(to) * size - size * 1.5f;
+    x = max(0.0f, min(x, 8 * size - size * 4));
+    chooser.topLeft = sf::Vector2f(x, rowOf(to) * size);
 }
 
-// HELPER FUNCTIONS FOR SFML
-
-void initializeBoard() {
-    //Initializing with empty squares
-    for (int r = 0; r < 8; r++) {
-        for (int c = 0; c < 8; c++) {
-            board[r][c] = ' ';
+// index of the choice under world, -1 if none
+int promotionChoiceAt(const PromotionChooser& chooser, sf::Vector2f world, float size) {
+    for (int i = 0; i < 4; i++) {
+        sf::FloatRect box(chooser.topLeft.x + i * size, chooser.topLeft.y, size, size);
+        if (box.contains(world)) {
+            return i;
         }
     }
-
-    // Place black pieces(lowercase)
-    board[0][0] = 'r'; // Black Rook 
-    board[0][1] = 'n'; // Black Knight
-    board[0][2] = 'b'; // Black Bishop
-    board[0][3] = 'q'; // Black Queen
-    board[0][4] = 'k'; // Black King
-    board[0][5] = 'b';
-    board[0][6] = 'n';
-    board[0][7] = 'r';
-    for (int c = 0; c < 8; c++) {
-        board[1][c] = 'p'; // Black Pawns 
-    }
-
-    // Place white pieces(UPPERCASE)
-    board[7][0] = 'R'; // White Rook 
-    board[7][1] = 'N'; // White Knight
-    board[7][2] = 'B'; // White Bishop
-    board[7][3] = 'Q'; // White Queen
-    board[7][4] = 'K'; // White King
-    board[7][5] = 'B';
-    board[7][6] = 'N';
-    board[7][7] = 'R';
-    for (int c = 0; c < 8; c++) {
-        board[6][c] = 'P'; // White Pawns 
-    }
+    return -1;
 }
 
-// helper for scoring
-int getPieceValue(char p) {
-    char l = (p >= 'A' && p <= 'Z') ? p + 32 : p;
-    if (l == 'p') { return 1; }
-    if (l == 'n') { return 3; } // Knight = 3
-    if (l == 'b') { return 3; } // Bishop = 3
-    if (l == 'r') { return 5; }
-    if (l == 'q') { return 9; }
-    return 0;
-}
-
-// capture function
-void Capture_func(char capturedPiece) {
-    int val = getPieceValue(capturedPiece);
-    if (whiteTurn) {
-        whiteScore += val;
-    }
-    else {
-        blackScore += val;
-    }
-    cout << "   CAPTURED! Took piece: " << getPieceName(capturedPiece) << " (+" << val << ")" << endl;
-    cout << "   SCORE -> White: " << whiteScore << " | Black: " << blackScore << endl;
-}
-
-// pawn promotion with selection
-void handlePromotion(int r, int c, sf::RenderWindow& window, const sf::Texture* textures, const float size) {
-    bool isWhite = (r == 0);
-    if (!((board[r][c] == 'P' && r == 0) || (board[r][c] == 'p' && r == 7))) {
-        return; // no promotion needed
-    }
-
-    // pause game and show menu
-    bool choosing = true;
+void drawPromotion(sf::RenderWindow& window, const BoardRenderer& renderer, const PromotionChooser& chooser, float size) {
     sf::RectangleShape menuBox(sf::Vector2f(size * 4, size));
-    menuBox.setPosition(c * size - size * 1.5f, r * size); // center over pawn
-    // keep inside screen
-    if (menuBox.getPosition().x < 0) menuBox.setPosition(0, menuBox.getPosition().y);
-    if (menuBox.getPosition().x + size * 4 > 800) menuBox.setPosition(800 - size * 4, menuBox.getPosition().y);
-
+    menuBox.setPosition(chooser.topLeft);
     menuBox.setFillColor(sf::Color(200, 200, 200));
     menuBox.setOutlineColor(sf::Color::Black);
     menuBox.setOutlineThickness(2);
-
-    // options: Q, R, B, N
-    sf::Sprite options[4];
-    char pieces[4] = { 'Q', 'R', 'B', 'N' };
-    if (!isWhite) {
-        pieces[0] = 'q'; pieces[1] = 'r'; pieces[2] = 'b'; pieces[3] = 'n';
-    }
-
-    for (int i = 0; i < 4; i++) {
-        int id = getTextureID(pieces[i]);
-        options[i].setTexture(textures[id]);
-        options[i].setScale(size / textures[id].getSize().x, size / textures[id].getSize().y);
-        options[i].setPosition(menuBox.getPosition().x + i * size, menuBox.getPosition().y);
-    }
-
-    while (choosing && window.isOpen()) {
-        sf::Event e;
-        while (window.pollEvent(e)) {
-            if (e.type == sf::Event::Closed) {
-                window.close();
-                return;
-            }
-            if (e.type == sf::Event::MouseButtonPressed && e.mouseButton.button == sf::Mouse::Left) {
-                sf::Vector2i pixel = { e.mouseButton.x, e.mouseButton.y };
-                sf::Vector2f world = window.mapPixelToCoords(pixel);
-
-                // check clicks
-                for (int i = 0; i < 4; i++) {
-                    if (options[i].getGlobalBounds().contains(world)) {
-                        board[r][c] = pieces[i];
-                        choosing = false;
-                        cout << "Promoted to " << getPieceName(pieces[i]) << endl;
-                    }
-                }
-            }
-        }
-
-        window.draw(menuBox);
-        for (int i = 0; i < 4; i++) {
-            window.draw(options[i]);
-        }
-        window.display();
-    }
+    window.draw(menuBox);
+    renderer.drawPieceRow(window, chooser.choices, 4, chooser.topLeft);
 }
 
 // adjust view on resize
@@ -490,34 +139,88 @@ void resizeView(const sf::Window& window, sf::View& view) {
     }
 }
 
-int getTextureID(char p) {
-    if (p == 'P') { return 1; } if (p == 'R') { return 2; } if (p == 'N') { return 3; }
-    if (p == 'B') { return 4; } if (p == 'Q') { return 5; } if (p == 'K') { return 6; }
-    if (p == 'p') { return 7; } if (p == 'r') { return 8; } if (p == 'n') { return 9; }
-    if (p == 'b') { return 10; } if (p == 'q') { return 11; } if (p == 'k') { return 12; }
-    return 0;
-}
-
-string getPieceName(char p) {
-    if (p == 'P') { return "White Pawn"; }
-    if (p == 'p') { return "Black Pawn"; }
-    if (p == 'R') { return "White Rook"; }
-    if (p == 'r') { return "Black Rook"; }
-    if (p == 'N') { return "White Knight"; }
-    if (p == 'n') { return "Black Knight"; }
-    if (p == 'B') { return "White Bishop"; }
-    if (p == 'b') { return "Black Bishop"; }
-    if (p == 'Q') { return "White Queen"; }
-    if (p == 'q') { return "Black Queen"; }
-    if (p == 'K') { return "White King"; }
-    if (p == 'k') { return "Black King"; }
-    return "Empty";
-}
-
-int main()
+int main(int argc, char* argv[])
 {
     //  INITIALIZE BOARD 
-    initializeBoard();
+    initBitboards(); // attack tables, once at startup
+
+    // command line:
+    //   --uci                    UCI engine on stdin/stdout, no window
+    //   --analyze [fen]          search the position and print the lines, no window
+    //   --computer white|black   let the engine play that colour
+    //   --depth N / --movetime ms / --nodes N   engine limits
+    //   --hash MB                transposition table size (default 16)
+    //   --threads N              search threads sharing the table (default 1)
+    //   --nnue [file]            evaluate with the network (built-in one without a file)
+    //   --book file              play the computer's opening moves from a Polyglot book
+    //   --book-keys file         Polyglot random table to use instead of the built-in one
+    //   --tb dir                 endgame tables (tbgen) for the search and the computer's moves
+    //   --ponder                 analyse the position in the background while you think
+    //   --log debug|info|warn|error|off   console log level (default debug, clicks included)
+    //   --events file            write the game events to file, one JSON object per line
+    string fen = StartFEN;
+    bool uci = false;
+    bool analyze = false;
+    bool ponder = false;
+    LogLevel logLevel = LOG_DEBUG;
+    string eventsFile;
+    int computerSide = -1; // none
+    SearchLimits limits;
+    EngineOptions opts;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--uci") {
+            uci = true;
+        }
+        else if (arg == "--analyze") {
+            analyze = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                fen = argv[++i];
+            }
+        }
+        else if (arg == "--ponder") {
+            ponder = true;
+        }
+        else if (arg == "--log" && i + 1 < argc) { logLevel = parseLogLevel(argv[++i], logLevel); }
+        else if (arg == "--events" && i + 1 < argc) { eventsFile = argv[++i]; }
+        else if (arg == "--computer" && i + 1 < argc) {
+            computerSide = string(argv[++i]) == "white" ? WHITE : BLACK;
+        }
+        else if (arg == "--depth" && i + 1 < argc) { limits.depth = atoi(argv[++i]); }
+        else if (arg == "--movetime" && i + 1 < argc) { limits.movetime = atoi(argv[++i]); }
+        else if (arg == "--nodes" && i + 1 < argc) { limits.nodes = strtoull(argv[++i], nullptr, 10); }
+        else if (arg == "--hash" && i + 1 < argc) { opts.hashMb = atoi(argv[++i]); }
+        else if (arg == "--threads" && i + 1 < argc) { opts.threads = atoi(argv[++i]); }
+        else if (arg == "--book" && i + 1 < argc) { opts.bookFile = argv[++i]; }
+        else if (arg == "--book-keys" && i + 1 < argc) { opts.bookKeys = argv[++i]; }
+        else if (arg == "--tb" && i + 1 < argc) { opts.tbPath = argv[++i]; }
+        else if (arg == "--nnue") {
+            opts.nnue = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                opts.nnueFile = argv[++i];
+            }
+        }
+    }
+    if (uci) {
+        return runUci(opts);
+    }
+    if (!limits.depth && !limits.movetime && !limits.nodes) {
+        limits.movetime = analyze ? 10000 : 1000;
+    }
+    if (analyze) {
+        return runAnalysis(fen, limits, opts);
+    }
+
+    // console output of the window goes through the async logger
+    startLog(logLevel, eventsFile);
+
+    // game is the latest state from the worker, shown is what is drawn: a
+    // dropped move shows at once, the worker's answer follows a frame later
+    Game game;
+    Position shown = game.position();
+    int movesInFlight = 0;
+    AnalysisWorker worker(game, opts, limits, computerSide, ponder);
+    string statusMsg = "";
 
     // create game window
     sf::RenderWindow window(sf::VideoMode(800, 800), "Chess Phase 5");
@@ -525,16 +228,11 @@ int main()
     window.setView(view);
 
     const float size = 100.0f;
-    sf::RectangleShape squares[8][8];
 
     // font setup for board text
     sf::Font font;
   
     bool hasFont = font.loadFromFile("arial.ttf");
-    sf::Text text;
-    text.setFont(font);
-    text.setCharacterSize(20);
-    text.setFillColor(sf::Color::Black);
 
     // score text setup
     sf::Text scoreText;
@@ -545,50 +243,73 @@ int main()
     scoreText.setOutlineColor(sf::Color::White);
     scoreText.setOutlineThickness(2);
 
-    // set colors
-    for (int r = 0; r < 8; ++r) {
-        for (int c = 0; c < 8; ++c) {
-            squares[r][c].setSize(sf::Vector2f(size, size));
-            squares[r][c].setPosition(c * size, r * size);
-            if ((r + c) % 2 == 0) {
-                squares[r][c].setFillColor(sf::Color(230, 235, 240)); // light blue
-            }
-            else {
-                squares[r][c].setFillColor(sf::Color(60, 90, 140)); // dark blue
-            }
-        }
-    }
-
-    // load piece images
-    sf::Texture tex[13];
-    if (!tex[1].loadFromFile("wP.png")) { cout << "error loading wP.png" << endl; }
-    tex[2].loadFromFile("wR.png"); tex[3].loadFromFile("wN.png");
-    tex[4].loadFromFile("wB.png"); tex[5].loadFromFile("wQ.png"); tex[6].loadFromFile("wK.png");
-    tex[7].loadFromFile("bP.png"); tex[8].loadFromFile("bR.png"); tex[9].loadFromFile("bN.png");
-    tex[10].loadFromFile("bB.png"); tex[11].loadFromFile("bQ.png"); tex[12].loadFromFile("bK.png");
-
-    sf::Sprite sprite[8][8];
+    // squares, highlights and pieces (from one atlas of the piece images)
+    BoardRenderer renderer(size);
+    renderer.loadPieces();
+    renderer.buildBoardLayer(hasFont ? &font : nullptr);
 
     // drag state variables
     bool dragging = false;
     int dr = -1, dc = -1;
-    sf::Sprite mover;
-
-    // selection highlight box
-    sf::RectangleShape selector(sf::Vector2f(size, size));
-    selector.setFillColor(sf::Color(0, 255, 0, 100));
-    bool selected = false;
+    Piece moverPiece = NO_PIECE;
+    sf::Vector2f moverPos;
+
+    // selection box plus valid move hints, rebuilt on press and release
+    vector<Highlight> marks;
+
+    PromotionChooser promotion;
+
+    // legality from the cached list, the rest on the worker; the move shows
+    // at once on the drawn board. With no move in flight the drawn board is
+    // the worker's position, so a move legal in game is legal in shown.
+    auto playMove = [&](Square from, Square to, PieceType promo) {
+        Move m = movesInFlight == 0 ? game.findMove(from, to, promo) : MOVE_NONE;
+        if (m != MOVE_NONE) {
+            shown.makeMove(m);
+            worker.submitMove(from, to, promo);
+            movesInFlight++;
+        }
+        else {
+            LOG_EVENT(LOG_WARN, EVENT_ILLEGAL, from, to);
+        }
+    };
 
-    // valid move hints
-    sf::RectangleShape hints[64];
-    int hCount = 0;
+    // frames are only drawn when something changed; while nothing does the
+    // loop sleeps in waitEvent. The limit paces drag updates.
+    window.setFramerateLimit(MaxFps);
+    bool dirty = true;
 
     //  GAME LOOP 
     while (window.isOpen())
     {
+        // worker results first; busy is read before polling so a result
+        // posted just before the worker went idle is still picked up
+        bool workerBusy = worker.busy();
+        AnalysisResult res;
+        while (worker.poll(res)) {
+            if (res.type == RESULT_INFO) {
+                LOG_TEXT(LOG_INFO, res.line.data(), res.line.size());
+                continue;
+            }
+            if (!res.byEngine) {
+                movesInFlight--;
+            }
+            game.load(res.game, res.legal);
+            shown = game.position();
+            if (res.result != MOVE_ILLEGAL) {
+                reportMove(game, res.result, res.byEngine, statusMsg);
+            }
+            dirty = true;
+        }
+
         sf::Event event;
-        while (window.pollEvent(event))
+        bool gotEvent = dirty || workerBusy ? window.pollEvent(event) : window.waitEvent(event);
+        for (; gotEvent; gotEvent = window.pollEvent(event))
         {
+            // mouse motion only shows while a piece is dragged
+            if (event.type != sf::Event::MouseMoved || dragging) {
+                dirty = true;
+            }
             if (event.type == sf::Event::Closed) {
                 window.close();
             }
@@ -597,9 +318,25 @@ int main()
                 window.setView(view);
             }
 
-            if (gameOver) {
+            // no input while the worker has not caught up or the computer
+            // thinks; checked per event, a drop earlier in the batch puts a
+            // move in flight
+            bool locked = movesInFlight > 0 || computerSide == game.sideToMove();
+            if (game.isOver() || locked) {
                 // stop input
             }
+            else if (promotion.active) {
+                // only the menu takes clicks until a piece is chosen
+                if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
+                    sf::Vector2i pixel = { event.mouseButton.x, event.mouseButton.y };
+                    int i = promotionChoiceAt(promotion, window.mapPixelToCoords(pixel), size);
+                    if (i >= 0) {
+                        LOG_EVENT(LOG_INFO, EVENT_PROMOTION, promotion.choices[i]);
+                        promotion.active = false;
+                        playMove(promotion.from, promotion.to, typeOf(promotion.choices[i]));
+                    }
+                }
+            }
             else {
                 // handle mouse click
                 if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left)
@@ -611,56 +348,32 @@ int main()
 
                     if (r >= 0 && r < 8 && c >= 0 && c < 8) {
 
-                        char ac = 'a' + c;// convert column to letter ,algabric cordinates
-                        int ar = 8 - r;// convert row to chess numbers
-                        char p = board[r][c];
-                        cout << "Clicked: " << ac << ar << " (Row " << r << ", Col " << c << ")";
-                        if (p != ' ') {
-                            cout << " -> " << getPieceName(p);
-                        }
-                        cout << endl;
+                        char p = pieceToChar(game.position().pieceOn(squareAt(r, c)));
+                        LOG_EVENT(LOG_DEBUG, EVENT_CLICK, squareAt(r, c), game.position().pieceOn(squareAt(r, c)));
 
-                        selected = true;
-                        selector.setPosition(c * size, r * size);
+                        // selection highlight box
+                        marks.clear();
+                        marks.push_back({ squareAt(r, c), sf::Color(0, 255, 0, 100) });
 
                         if (p != ' ') {
                             dragging = true;
                             dr = r; dc = c;
-                            int id = getTextureID(p);
-                            mover.setTexture(tex[id]);
-                            mover.setScale(size / tex[id].getSize().x, size / tex[id].getSize().y);
-                            mover.setPosition(world.x - size / 2, world.y - size / 2); // center of cursor
+                            moverPiece = pieceFromChar(p);
+                            moverPos = sf::Vector2f(world.x - size / 2, world.y - size / 2); // center of cursor
 
                             // show valid moves with red capture hint
-                            hCount = 0;
-                            for (int checkRow = 0; checkRow < 8; checkRow++) {
-                                for (int checkCol = 0; checkCol < 8; checkCol++) {
-                                    if (isValidMove(dr, dc, checkRow, checkCol)) {
-                                        hints[hCount].setSize(sf::Vector2f(size, size));
-                                        hints[hCount].setPosition(checkCol * size, checkRow * size);
-
-                                        // red for capture
-                                        // check valid capture target 
-                                        char targetP = board[checkRow][checkCol];
-                                        bool isCapture = false;
-                                        if (targetP != ' ') {
-                                            isCapture = true;
-                                        }
-
-                                        if (isCapture) {
-                                            hints[hCount].setFillColor(sf::Color(255, 0, 0, 100));
-                                        }
-                                        else {
-                                            hints[hCount].setFillColor(sf::Color(0, 255, 0, 100));
-                                        }
-                                        hCount++;
-                                    }
+                            Square from = squareAt(dr, dc);
+                            for (Move m : game.legalMoves()) {
+                                // one hint per promotion square
+                                if (fromSq(m) != from || (typeOfMove(m) == PROMOTION && promotionType(m) != QUEEN)) {
+                                    continue;
                                 }
+                                // red for capture
+                                bool capture = game.position().capturedBy(m) != NO_PIECE;
+                                marks.push_back({ toSq(m), capture ? sf::Color(255, 0, 0, 100) : sf::Color(0, 255, 0, 100) });
                             }
                         }
-                        else {
-                            hCount = 0;
-                        }
+                        renderer.setHighlights(marks);
                     }
                 }
 
@@ -668,7 +381,7 @@ int main()
                 if (event.type == sf::Event::MouseMoved && dragging) {
                     sf::Vector2i pixel = { event.mouseMove.x, event.mouseMove.y };
                     sf::Vector2f world = window.mapPixelToCoords(pixel);
-                    mover.setPosition(world.x - size / 2, world.y - size / 2);
+                    moverPos = sf::Vector2f(world.x - size / 2, world.y - size / 2);
                 }
 
                 // drop the piece
@@ -680,176 +393,98 @@ int main()
                     int nr = world.y / size;
 
                     if (nr >= 0 && nr < 8 && nc >= 0 && nc < 8) {
-                        if (isValidMove(dr, dc, nr, nc)) {
-
-                            char tempDest = board[nr][nc];
-                            board[nr][nc] = board[dr][dc];
-                            board[dr][dc] = ' ';
-
-                            // check self-check
-                            if (isCheck(whiteTurn)) {
-                                // undo unsafe move
-                                board[dr][dc] = board[nr][nc];
-                                board[nr][nc] = tempDest;
-                                cout << "invalid: king is in check" << endl;
-                            }
-                            else {
-                                // valid move
-
-                                // check capture
-                                if (tempDest != ' ') {
-                                    Capture_func(tempDest);
-                                }
+                        Square from = squareAt(dr, dc);
+                        Square to = squareAt(nr, nc);
 
-                                // pawn promotion check and menu
-                                handlePromotion(nr, nc, window, tex, size);
-
-                                whiteTurn = !whiteTurn;
-                                cout << "Move Valid. " << (whiteTurn ? "White" : "Black") << "'s turn." << endl;
-
-                                // check game over conditions
-                                if (isCheckmate(whiteTurn)) {
-                                    statusMsg = (whiteTurn ? "Black" : "White");
-                                    statusMsg += " Wins!";
-                                    if (whiteTurn) { // Black Won
-                                        statusMsg += "\nBlack Score: " + to_string(blackScore);
-                                    }
-                                    else { // White Won
-                                        statusMsg += "\nWhite Score: " + to_string(whiteScore);
-                                    }
-                                    cout << statusMsg << endl;
-                                    gameOver = true;
-                                }
-                                else if (isStalemate(whiteTurn)) {
-                                    statusMsg = "Draw!";
-                                    statusMsg += "\nBlack Score: " + to_string(blackScore);
-                                    cout << statusMsg << endl;
-                                    gameOver = true;
-                                }
-                                else if (isCheck(whiteTurn)) {
-                                    cout << "CHECK!" << endl;
-                                    isKingInCheck = true; // FIXED: Enable check text
-                                }
-                                else {
-                                    isKingInCheck = false; // FIXED: Disable check text if safe
-                                }
-                            }
+                        // pawn promotion menu before the move is played
+                        if (game.isPromotion(from, to)) {
+                            openPromotion(promotion, from, to, game.sideToMove(), size);
                         }
                         else {
-                            cout << "Invalid Move!" << endl;
+                            playMove(from, to, QUEEN);
                         }
                     }
                     dragging = false;
-                    hCount = 0;
+                    marks.resize(1); // keep the selection box, drop the hints
+                    renderer.setHighlights(marks);
                 }
             } // end of else block
         }
 
-        window.clear();
-        window.setView(view);
-
-        // Draw Board
-        for (int r = 0; r < 8; ++r) {
-            for (int c = 0; c < 8; ++c) {
-                window.draw(squares[r][c]);
-
-                // draw coordinates
-                if (hasFont) {
-                    // 1-8 left
-                    if (c == 0) {
-                        text.setString(to_string(8 - r));
-                        // center in vertical space of tile
-                        text.setPosition(5, r * size + size / 2 - 10);
-                        window.draw(text);
-                    }
-                    // a-h bottom (last row)
-                    if (r == 7) {
-                        string s = "";
-                        s += (char)('a' + c);
-                        text.setString(s);
-                        // bottom left corner of the box
-                        text.setPosition(c * size + 5, (r + 1) * size - 25);
-                        window.draw(text);
-                    }
-                }
-            }
-        }
+        if (dirty) {
+            window.clear();
+            window.setView(view);
 
-        // Draw Highlights
-        if (selected) {
-            window.draw(selector);
-        }
-        for (int i = 0; i < hCount; i++) {
-            window.draw(hints[i]);
-        }
+            // pieces array is only rebuilt when the position or the drag changed
+            renderer.setPosition(shown, dragging ? squareAt(dr, dc) : NO_SQUARE);
 
-        // Draw Chess Pieces (Sprites)
-        for (int r = 0; r < 8; r++) {
-            for (int c = 0; c < 8; c++) {
-                if (!(dragging && r == dr && c == dc)) {
-                    char p = board[r][c];
-                    int id = getTextureID(p);
-                    if (id != 0) {
-                        sprite[r][c].setTexture(tex[id]);
-                        sprite[r][c].setScale(size / tex[id].getSize().x, size / tex[id].getSize().y);
-                        sprite[r][c].setPosition(c * size, r * size);
-                        window.draw(sprite[r][c]);
-                    }
-                }
-            }
-        }
+            // Draw Board (squares and coordinates, cached)
+            renderer.drawBoard(window);
 
-        if (hasFont) {
-            scoreText.setCharacterSize(24);
-            scoreText.setOrigin(0, 0);
+            // Draw Highlights and Chess Pieces, one draw call each
+            renderer.drawHighlights(window);
+            renderer.drawPieces(window);
 
-            // set score text color
-            scoreText.setFillColor(sf::Color::Red);
+            if (hasFont) {
+                scoreText.setCharacterSize(24);
+                scoreText.setOrigin(0, 0);
 
-            scoreText.setString("W: " + to_string(whiteScore));
-            scoreText.setPosition(10, 10);
-            window.draw(scoreText);
+                // set score text color
+                scoreText.setFillColor(sf::Color::Red);
 
-            scoreText.setString("B: " + to_string(blackScore));
-            scoreText.setPosition(700, 10);
-            window.draw(scoreText);
+                scoreText.setString("W: " + to_string(game.score(WHITE)));
+                scoreText.setPosition(10, 10);
+                window.draw(scoreText);
 
-            //  Draw Check Notification
-            if (isKingInCheck && !gameOver) {
-                scoreText.setString("CHECK!");
-                sf::FloatRect checkRect = scoreText.getLocalBounds();
-                scoreText.setOrigin(checkRect.left + checkRect.width / 2.0f, checkRect.top + checkRect.height / 2.0f);
-                scoreText.setPosition(265, 400); // Center of board
-                scoreText.setCharacterSize(80);
-                scoreText.setFillColor(sf::Color::Red);
-                scoreText.setOutlineColor(sf::Color::White);
-                scoreText.setOutlineThickness(3);
+                scoreText.setString("B: " + to_string(game.score(BLACK)));
+                scoreText.setPosition(700, 10);
                 window.draw(scoreText);
-            }
 
-            if (gameOver) {
-                // big game over text
-                scoreText.setString(statusMsg);
-                sf::FloatRect textRect = scoreText.getLocalBounds();
-                scoreText.setOrigin(textRect.left + textRect.width / 2.0f, textRect.top + textRect.height / 2.0f);
-                scoreText.setPosition(265, 400); // center of 800x800
-                scoreText.setCharacterSize(60);
-                scoreText.setOutlineThickness(4);
-                scoreText.setOutlineColor(sf::Color::Black);
-                scoreText.setFillColor(sf::Color::Green);
+                //  Draw Check Notification
+                if (game.inCheck() && !game.isOver()) {
+                    scoreText.setString("CHECK!");
+                    sf::FloatRect checkRect = scoreText.getLocalBounds();
+                    scoreText.setOrigin(checkRect.left + checkRect.width / 2.0f, checkRect.top + checkRect.height / 2.0f);
+                    scoreText.setPosition(265, 400); // Center of board
+                    scoreText.setCharacterSize(80);
+                    scoreText.setFillColor(sf::Color::Red);
+                    scoreText.setOutlineColor(sf::Color::White);
+                    scoreText.setOutlineThickness(3);
+                    window.draw(scoreText);
+                }
+
+                if (game.isOver()) {
+                    // big game over text
+                    scoreText.setString(statusMsg);
+                    sf::FloatRect textRect = scoreText.getLocalBounds();
+                    scoreText.setOrigin(textRect.left + textRect.width / 2.0f, textRect.top + textRect.height / 2.0f);
+                    scoreText.setPosition(265, 400); // center of 800x800
+                    scoreText.setCharacterSize(60);
+                    scoreText.setOutlineThickness(4);
+                    scoreText.setOutlineColor(sf::Color::Black);
+                    scoreText.setFillColor(sf::Color::Green);
 
             
 
-                window.draw(scoreText);
+                    window.draw(scoreText);
+                }
             }
-        }
 
-        // Draw Dragged Piece (Always on top)
-        if (dragging) {
-            window.draw(mover);
-        }
+            // Draw Dragged Piece (Always on top)
+            if (dragging) {
+                renderer.drawPiece(window, moverPiece, moverPos);
+            }
+            if (promotion.active) {
+                drawPromotion(window, renderer, promotion, size);
+            }
 
-        window.display();
+            window.display();
+            dirty = false;
+        }
+        else if (workerBusy) {
+            sf::sleep(sf::milliseconds(WorkerPollMs));
+        }
     }
+    stopLog();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,414 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include "Evaluate.h"
+#include "Nnue.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define NNUE_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// per-function instruction sets, so one binary carries every kernel
+#if defined(NNUE_X86) && !defined(_MSC_VER)
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE41
+#define TARGET_AVX2
+#endif
+
+using namespace std;
+
+namespace {
+
+const int L1_SHIFT = 6;        // l1 sums are scaled down by 64 before clipping
+const int OUTPUT_SCALE = 16;   // output sum / 16 = centipawns
+const int MAX_ADDS = 3;
+
+struct Network {
+    alignas(64) int16_t ftWeights[NNUE_INPUTS][NNUE_HIDDEN];
+    alignas(64) int16_t ftBias[NNUE_HIDDEN];
+    alignas(64) int8_t l1Weights[NNUE_L1][2 * NNUE_HIDDEN];
+    int32_t l1Bias[NNUE_L1];
+    int8_t outWeights[NNUE_L1];
+    int32_t outBias;
+};
+
+Network net;
+
+const char FileMagic[8] = { 'C', 'H', 'E', 'S', 'S', 'N', 'N', '1' };
+
+// input index of pc on s seen from persp: black looks at a mirrored board
+// and both sides see their own pieces as the first 384 inputs
+inline int featureIndex(Color persp, Piece pc, Square s) {
+    int rel = persp == WHITE ? s : s ^ 56;
+    int side = colorOf(pc) == persp ? 0 : 1;
+    return (side * 6 + typeOf(pc)) * 64 + rel;
+}
+
+// KERNELS
+// accUpdate: dst = src + sum(adds) - sum(subs), NNUE_HIDDEN lanes
+// forward: both accumulators -> output in centipawns
+
+typedef void (*AccUpdateFn)(int16_t* dst, const int16_t* src, const int16_t* const* adds, int nAdd,
+                            const int16_t* const* subs, int nSub);
+typedef int (*ForwardFn)(const int16_t* us, const int16_t* them);
+
+void accUpdateScalar(int16_t* dst, const int16_t* src, const int16_t* const* adds, int nAdd,
+                     const int16_t* const* subs, int nSub) {
+    for (int i = 0; i < NNUE_HIDDEN; i++) {
+        int v = src[i];
+        for (int a = 0; a < nAdd; a++) {
+            v += adds[a][i];
+        }
+        for (int b = 0; b < nSub; b++) {
+            v -= subs[b][i];
+        }
+        dst[i] = (int16_t)v;
+    }
+}
+
+int outputLayer(const int32_t* l1) {
+    int32_t sum = net.outBias;
+    for (int j = 0; j < NNUE_L1; j++) {
+        int v = min(max(l1[j] >> L1_SHIFT, 0), 127);
+        sum += v * net.outWeights[j];
+    }
+    return sum / OUTPUT_SCALE;
+}
+
+int forwardScalar(const int16_t* us, const int16_t* them) {
+    uint8_t input[2 * NNUE_HIDDEN];
+    for (int i = 0; i < NNUE_HIDDEN; i++) {
+        input[i] = (uint8_t)min(max((int)us[i], 0), 127);
+        input[NNUE_HIDDEN + i] = (uint8_t)min(max((int)them[i], 0), 127);
+    }
+    int32_t l1[NNUE_L1];
+    for (int j = 0; j < NNUE_L1; j++) {
+        int32_t sum = net.l1Bias[j];
+        for (int i = 0; i < 2 * NNUE_HIDDEN; i++) {
+            sum += input[i] * net.l1Weights[j][i];
+        }
+        l1[j] = sum;
+    }
+    return outputLayer(l1);
+}
+
+#if defined(NNUE_X86)
+
+TARGET_SSE41
+void accUpdateSse41(int16_t* dst, const int16_t* src, const int16_t* const* adds, int nAdd,
+                    const int16_t* const* subs, int nSub) {
+    for (int i = 0; i < NNUE_HIDDEN; i += 8) {
+        __m128i v = _mm_load_si128((const __m128i*)(src + i));
+        for (int a = 0; a < nAdd; a++) {
+            v = _mm_add_epi16(v, _mm_load_si128((const __m128i*)(adds[a] + i)));
+        }
+        for (int b = 0; b < nSub; b++) {
+            v = _mm_sub_epi16(v, _mm_load_si128((const __m128i*)(subs[b] + i)));
+        }
+        _mm_store_si128((__m128i*)(dst + i), v);
+    }
+}
+
+// 16 int16 -> 16 uint8 clipped to 0..127
+TARGET_SSE41
+inline __m128i clip16Sse(const int16_t* p) {
+    const __m128i max127 = _mm_set1_epi16(127);
+    __m128i a = _mm_min_epi16(_mm_load_si128((const __m128i*)p), max127);
+    __m128i b = _mm_min_epi16(_mm_load_si128((const __m128i*)(p + 8)), max127);
+    return _mm_packus_epi16(a, b);
+}
+
+TARGET_SSE41
+int forwardSse41(const int16_t* us, const int16_t* them) {
+    const int chunks = 2 * NNUE_HIDDEN / 16;
+    __m128i input[chunks];
+    for (int c = 0; c < NNUE_HIDDEN / 16; c++) {
+        input[c] = clip16Sse(us + c * 16);
+        input[NNUE_HIDDEN / 16 + c] = clip16Sse(them + c * 16);
+    }
+    const __m128i ones = _mm_set1_epi16(1);
+    int32_t l1[NNUE_L1];
+    for (int j = 0; j < NNUE_L1; j++) {
+        __m128i sum = _mm_setzero_si128();
+        const __m128i* w = (const __m128i*)net.l1Weights[j];
+        for (int c = 0; c < chunks; c++) {
+            // u8 x i8 pairs -> i16 (at most 2 * 127 * 127, no saturation) -> i32
+            __m128i prod = _mm_maddubs_epi16(input[c], _mm_load_si128(w + c));
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(prod, ones));
+        }
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+        l1[j] = _mm_cvtsi128_si32(sum) + net.l1Bias[j];
+    }
+    return outputLayer(l1);
+}
+
+TARGET_AVX2
+void accUpdateAvx2(int16_t* dst, const int16_t* src, const int16_t* const* adds, int nAdd,
+                   const int16_t* const* subs, int nSub) {
+    for (int i = 0; i < NNUE_HIDDEN; i += 16) {
+        __m256i v = _mm256_load_si256((const __m256i*)(src + i));
+        for (int a = 0; a < nAdd; a++) {
+            v = _mm256_add_epi16(v, _mm256_load_si256((const __m256i*)(adds[a] + i)));
+        }
+        for (int b = 0; b < nSub; b++) {
+            v = _mm256_sub_epi16(v, _mm256_load_si256((const __m256i*)(subs[b] + i)));
+        }
+        _mm256_store_si256((__m256i*)(dst + i), v);
+    }
+}
+
+// 32 int16 -> 32 uint8 clipped to 0..127, in order
+TARGET_AVX2
+inline __m256i clip32Avx2(const int16_t* p) {
+    const __m256i max127 = _mm256_set1_epi16(127);
+    __m256i a = _mm256_min_epi16(_mm256_load_si256((const __m256i*)p), max127);
+    __m256i b = _mm256_min_epi16(_mm256_load_si256((const __m256i*)(p + 16)), max127);
+    // packus works per 128-bit lane, put the quarters back in order
+    return _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8);
+}
+
+TARGET_AVX2
+int forwardAvx2(const int16_t* us, const int16_t* them) {
+    const int chunks = 2 * NNUE_HIDDEN / 32;
+    __m256i input[chunks];
+    for (int c = 0; c < NNUE_HIDDEN / 32; c++) {
+        input[c] = clip32Avx2(us + c * 32);
+        input[NNUE_HIDDEN / 32 + c] = clip32Avx2(them + c * 32);
+    }
+    const __m256i ones = _mm256_set1_epi16(1);
+    int32_t l1[NNUE_L1];
+    for (int j = 0; j < NNUE_L1; j++) {
+        __m256i sum = _mm256_setzero_si256();
+        const __m256i* w = (const __m256i*)net.l1Weights[j];
+        for (int c = 0; c < chunks; c++) {
+            __m256i prod = _mm256_maddubs_epi16(input[c], _mm256_load_si256(w + c));
+            sum = _mm256_add_epi32(sum, _mm256_madd_epi16(prod, ones));
+        }
+        __m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+        s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+        l1[j] = _mm_cvtsi128_si32(s) + net.l1Bias[j];
+    }
+    return outputLayer(l1);
+}
+
+#endif
+
+struct KernelSet {
+    AccUpdateFn accUpdate;
+    ForwardFn forward;
+};
+
+KernelSet kernels = { accUpdateScalar, forwardScalar };
+NnueKernel activeKernel = KERNEL_SCALAR;
+
+bool cpuHasSse41() {
+#if defined(NNUE_X86) && defined(_MSC_VER)
+    int r[4];
+    __cpuid(r, 1);
+    return (r[2] & (1 << 19)) != 0;
+#elif defined(NNUE_X86)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.1");
+#else
+    return false;
+#endif
+}
+
+bool cpuHasAvx2() {
+#if defined(NNUE_X86) && defined(_MSC_VER)
+    int r[4];
+    __cpuid(r, 1);
+    bool osSavesYmm = (r[2] & (1 << 27)) && (r[2] & (1 << 28)) && ((_xgetbv(0) & 6) == 6);
+    __cpuidex(r, 7, 0);
+    return osSavesYmm && (r[1] & (1 << 5));
+#elif defined(NNUE_X86)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+// default network: reproduces the middlegame material + piece-square score.
+// Eight accumulator neurons per (our/their, piece type) each hold a slightly
+// offset copy of value / 16, so their sum is value / 2 without much rounding;
+// the l1 layer sums ours - theirs into a staircase of 16 positive and 16
+// negative clipped neurons whose weighted sum is the linear score again
+void buildDefaultNetwork() {
+    memset((void*)&net, 0, sizeof(net));
+    const int group = 8;
+    const int bias = 32;
+    for (int side = 0; side < 2; side++) {
+        for (int pt = PAWN; pt <= KING; pt++) {
+            for (Square rel = 0; rel < 64; rel++) {
+                // own pieces use the white table as is, enemy pieces see the
+                // board from the other end
+                Square s = side == 0 ? rel : rel ^ 56;
+                int value = PsqMg[makePiece(WHITE, PieceType(pt))][s];
+                int feature = (side * 6 + pt) * 64 + rel;
+                for (int k = 0; k < group; k++) {
+                    int v = value + 2 * k;
+                    net.ftWeights[feature][(side * 6 + pt) * group + k] = (int16_t)(v >= 0 ? v / 16 : -((-v + 15) / 16));
+                }
+            }
+            for (int k = 0; k < group; k++) {
+                net.ftBias[(side * 6 + pt) * group + k] = bias;
+            }
+        }
+    }
+    // biases cancel: both sides have 6 * group neurons at +bias
+    for (int j = 0; j < NNUE_L1; j++) {
+        int sign = j < NNUE_L1 / 2 ? 1 : -1;
+        for (int n = 0; n < 12 * group; n++) {
+            int side = n / (6 * group);
+            net.l1Weights[j][n] = (int8_t)(sign * (side == 0 ? 2 : -2));
+        }
+        net.l1Bias[j] = 4 * (j % (NNUE_L1 / 2));
+        net.outWeights[j] = (int8_t)(sign * 64);
+    }
+    net.outBias = 0;
+}
+
+} // namespace
+
+bool nnueKernelSupported(NnueKernel k) {
+    switch (k) {
+    case KERNEL_SCALAR: return true;
+    case KERNEL_SSE41: return cpuHasSse41();
+    case KERNEL_AVX2: return cpuHasAvx2();
+    default: return false;
+    }
+}
+
+bool nnueSetKernel(NnueKernel k) {
+    if (!nnueKernelSupported(k)) {
+        return false;
+    }
+    switch (k) {
+#if defined(NNUE_X86)
+    case KERNEL_SSE41: kernels = { accUpdateSse41, forwardSse41 }; break;
+    case KERNEL_AVX2: kernels = { accUpdateAvx2, forwardAvx2 }; break;
+#endif
+    default: kernels = { accUpdateScalar, forwardScalar }; break;
+    }
+    activeKernel = k;
+    return true;
+}
+
+NnueKernel nnueKernel() {
+    return activeKernel;
+}
+
+const char* nnueKernelName(NnueKernel k) {
+    static const char* names[KERNEL_NB] = { "scalar", "sse4.1", "avx2" };
+    return k < KERNEL_NB ? names[k] : "?";
+}
+
+void nnueInit() {
+    buildDefaultNetwork();
+    if (!nnueSetKernel(KERNEL_AVX2) && !nnueSetKernel(KERNEL_SSE41)) {
+        nnueSetKernel(KERNEL_SCALAR);
+    }
+}
+
+// file: 8-byte magic, hidden and l1 sizes as int32, then the arrays in
+// Network order, little endian
+bool nnueLoad(const string& path) {
+    ifstream in(path, ios::binary);
+    if (!in) {
+        return false;
+    }
+    char magic[8];
+    int32_t hidden = 0, l1 = 0;
+    in.read(magic, 8);
+    in.read((char*)&hidden, 4);
+    in.read((char*)&l1, 4);
+    if (!in || memcmp(magic, FileMagic, 8) != 0 || hidden != NNUE_HIDDEN || l1 != NNUE_L1) {
+        return false;
+    }
+
+    static Network loaded;
+    in.read((char*)loaded.ftWeights, sizeof(loaded.ftWeights));
+    in.read((char*)loaded.ftBias, sizeof(loaded.ftBias));
+    in.read((char*)loaded.l1Weights, sizeof(loaded.l1Weights));
+    in.read((char*)loaded.l1Bias, sizeof(loaded.l1Bias));
+    in.read((char*)loaded.outWeights, sizeof(loaded.outWeights));
+    in.read((char*)&loaded.outBias, sizeof(loaded.outBias));
+    if (!in || in.peek() != EOF) {
+        return false;
+    }
+    memcpy((void*)&net, (const void*)&loaded, sizeof(net));
+    return true;
+}
+
+const Accumulator& NnueEvaluator::update(const Position& pos) {
+    int n = pos.historySize();
+    if ((int)stack.size() <= n) {
+        stack.resize(n + 1);  // new entries are zeroed, so not computed
+    }
+    Accumulator& top = stack[n];
+    if (top.computed && top.key == pos.key()) {
+        return top;
+    }
+
+    // nearest ancestor on this line whose accumulator is still valid
+    const int maxReplay = 8;
+    int j = n - 1;
+    while (j >= 0 && n - j <= maxReplay && !(stack[j].computed && stack[j].key == pos.undoAt(j).key)) {
+        j--;
+    }
+
+    if (j < 0 || n - j > maxReplay) {
+        // full refresh from the board
+        for (int c = WHITE; c <= BLACK; c++) {
+            memcpy(top.values[c], net.ftBias, sizeof(net.ftBias));
+            Bitboard b = pos.pieces();
+            while (b) {
+                Square s = popLsb(b);
+                const int16_t* w = net.ftWeights[featureIndex(Color(c), pos.pieceOn(s), s)];
+                kernels.accUpdate(top.values[c], top.values[c], &w, 1, nullptr, 0);
+            }
+        }
+    }
+    else {
+        // replay the moves from j: parent + added pieces - removed pieces
+        for (int k = j; k < n; k++) {
+            const UndoInfo& u = pos.undoAt(k);
+            Accumulator& next = stack[k + 1];
+            for (int c = WHITE; c <= BLACK; c++) {
+                const int16_t* adds[MAX_ADDS];
+                const int16_t* subs[MAX_ADDS];
+                int nAdd = 0, nSub = 0;
+                for (int d = 0; d < u.dirtyCount; d++) {
+                    Piece pc = Piece(u.dirty[d].piece);
+                    if (u.dirty[d].from != NO_SQUARE) {
+                        subs[nSub++] = net.ftWeights[featureIndex(Color(c), pc, u.dirty[d].from)];
+                    }
+                    if (u.dirty[d].to != NO_SQUARE) {
+                        adds[nAdd++] = net.ftWeights[featureIndex(Color(c), pc, u.dirty[d].to)];
+                    }
+                }
+                kernels.accUpdate(next.values[c], stack[k].values[c], adds, nAdd, subs, nSub);
+            }
+            next.key = k + 1 < n ? pos.undoAt(k + 1).key : pos.key();
+            next.computed = true;
+        }
+    }
+    top.key = pos.key();
+    top.computed = true;
+    return top;
+}
+
+int NnueEvaluator::evaluate(const Position& pos) {
+    const Accumulator& acc = update(pos);
+    Color us = pos.sideToMove();
+    return kernels.forward(acc.values[us], acc.values[~us]);
+}
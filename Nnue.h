@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "Position.h"
+
+// small NNUE-style network. Each side has its own view of the board as 768
+// piece/square inputs ("our"/"their" piece type x square, black's view
+// mirrored) feeding a 128-wide int16 accumulator. The side to move's
+// accumulator and the other one are clipped to 0..127 and concatenated
+// into a 32-neuron int8 layer, then a single output in centipawns.
+const int NNUE_INPUTS = 768;
+const int NNUE_HIDDEN = 128;
+const int NNUE_L1 = 32;
+
+enum NnueKernel { KERNEL_SCALAR, KERNEL_SSE41, KERNEL_AVX2, KERNEL_NB };
+
+// builds the compiled-in default network and picks the best kernel this cpu
+// supports; call once at startup before using the evaluator
+void nnueInit();
+
+// replace the weights with a network file, false (weights unchanged) on a
+// missing or malformed file
+bool nnueLoad(const std::string& path);
+
+// kernels: chosen at run time, forcing one the cpu lacks fails
+bool nnueKernelSupported(NnueKernel k);
+bool nnueSetKernel(NnueKernel k);
+NnueKernel nnueKernel();
+const char* nnueKernelName(NnueKernel k);
+
+struct alignas(64) Accumulator {
+    int16_t values[COLOR_NB][NNUE_HIDDEN];
+    uint64_t key;
+    bool computed;
+};
+
+// per-thread evaluator. It keeps one accumulator per move on the current
+// line; after makeMove() the new one is the parent's plus the pieces the
+// move changed (Position records them), after unmakeMove() the parent is
+// simply current again
+class NnueEvaluator {
+public:
+    // centipawns from the side to move's point of view
+    int evaluate(const Position& pos);
+
+    // forget all accumulators, e.g. after the weights changed
+    void reset() { stack.clear(); }
+
+private:
+    const Accumulator& update(const Position& pos);
+
+    std::vector<Accumulator> stack;  // stack[i] = position after i moves
+};
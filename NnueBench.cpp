@@ -0,0 +1,120 @@
+// headless benchmark for the network evaluator: evaluations per second for
+// every kernel this cpu supports, on the same random walk through positions
+//
+// usage: nnuebench [network file] [--evals N]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "Evaluate.h"
+#include "MoveGen.h"
+#include "Nnue.h"
+
+using namespace std;
+
+static const char* const BenchFens[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+};
+
+// random walks of up to 12 moves from the bench positions, recorded once
+// with a fixed seed so every evaluator sees the same positions
+struct Walk {
+    const char* fen;
+    vector<Move> moves;
+};
+
+vector<Walk> makeWalks(uint64_t evals) {
+    mt19937 rng(2024);
+    vector<Walk> walks;
+    uint64_t total = 0;
+    while (total < evals) {
+        for (const char* fen : BenchFens) {
+            Walk w;
+            w.fen = fen;
+            Position pos;
+            pos.setFen(fen);
+            while (w.moves.size() < 12 && total < evals) {
+                MoveList moves;
+                generateLegalMoves(pos, moves);
+                if (moves.size() == 0) {
+                    break;
+                }
+                Move m = moves[rng() % moves.size()];
+                pos.makeMove(m);
+                w.moves.push_back(m);
+                total++;
+            }
+            walks.push_back(w);
+        }
+    }
+    return walks;
+}
+
+// plays every walk, evaluating after each move and taking the moves back
+// like a search does; only this part is timed
+template <typename Eval>
+void report(const string& name, const vector<Walk>& walks, Eval eval) {
+    vector<Position> roots(walks.size());
+    for (size_t i = 0; i < walks.size(); i++) {
+        roots[i].setFen(walks[i].fen);
+    }
+
+    uint64_t evals = 0;
+    int64_t checksum = 0;
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < walks.size(); i++) {
+        Position& pos = roots[i];
+        for (Move m : walks[i].moves) {
+            pos.makeMove(m);
+            checksum += eval(pos);
+            evals++;
+        }
+        for (size_t j = 0; j < walks[i].moves.size(); j++) {
+            pos.unmakeMove();
+        }
+    }
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << name << ": " << (uint64_t)(evals / secs) << " evals/s  (checksum " << checksum << ")" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    initBitboards();
+    nnueInit();
+
+    uint64_t evals = 2000000;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--evals" && i + 1 < argc) {
+            evals = strtoull(argv[++i], nullptr, 10);
+        }
+        else if (!nnueLoad(arg)) {
+            cout << "could not load network " << arg << endl;
+            return 1;
+        }
+    }
+
+    vector<Walk> walks = makeWalks(evals);
+    vector<Walk> fewWalks(walks.begin(), walks.begin() + walks.size() / 10);
+
+    report("handcrafted", walks, [](const Position& pos) { return evaluate(pos); });
+
+    // checksums must match between kernels, they compute the same integers
+    for (int k = KERNEL_SCALAR; k < KERNEL_NB; k++) {
+        if (!nnueSetKernel(NnueKernel(k))) {
+            cout << nnueKernelName(NnueKernel(k)) << ": not supported by this cpu" << endl;
+            continue;
+        }
+        NnueEvaluator ev;
+        report(string("nnue ") + nnueKernelName(NnueKernel(k)), walks,
+               [&ev](const Position& pos) { return ev.evaluate(pos); });
+        report(string("nnue ") + nnueKernelName(NnueKernel(k)) + " full refresh", fewWalks,
+               [&ev](const Position& pos) { ev.reset(); return ev.evaluate(pos); });
+    }
+    return 0;
+}
@@ -0,0 +1,103 @@
+#include "Pawns.h"
+
+using namespace std;
+
+namespace {
+
+const int DoubledMg = 10, DoubledEg = 20;
+const int IsolatedMg = 10, IsolatedEg = 15;
+const int BackwardMg = 8, BackwardEg = 10;
+const int PassedMg[8] = { 0, 5, 10, 15, 30, 50, 80, 0 };   // by relative rank
+const int PassedEg[8] = { 0, 10, 20, 35, 60, 100, 150, 0 };
+const int ShieldNear = 10, ShieldFar = 5;
+
+// doubled, isolated, backward and passed pawns of colour c
+void evalPawns(const Position& pos, Color c, int& mg, int& eg) {
+    Bitboard ours = pos.pieces(c, PAWN);
+    Bitboard theirs = pos.pieces(~c, PAWN);
+    Bitboard theirAttacks = pawnAttacksBB(~c, theirs);
+
+    Bitboard b = ours;
+    while (b) {
+        Square s = popLsb(b);
+        int f = fileOf(s);
+        Bitboard ahead = forwardRanksBB(c, s);
+        Bitboard neighbours = ours & adjacentFilesBB(f);
+
+        if (ours & fileBB(f) & ahead) {
+            mg -= DoubledMg;
+            eg -= DoubledEg;
+        }
+
+        bool passed = !(theirs & ahead & (fileBB(f) | adjacentFilesBB(f)));
+        if (passed) {
+            int r = relativeRank(c, s);
+            mg += PassedMg[r];
+            eg += PassedEg[r];
+        }
+
+        if (!neighbours) {
+            mg -= IsolatedMg;
+            eg -= IsolatedEg;
+        }
+        else if (!passed) {
+            // no neighbour level with or behind it, and the stop square is
+            // held by an enemy pawn
+            Bitboard behindOrLevel = ~forwardRanksBB(c, s);
+            Square stop = c == WHITE ? s + 8 : s - 8;
+            if (!(neighbours & behindOrLevel) && (theirAttacks & squareBB(stop))) {
+                mg -= BackwardMg;
+                eg -= BackwardEg;
+            }
+        }
+    }
+}
+
+// own pawns on the king file and its neighbours on the 2nd and 3rd rank
+int pawnShield(const Position& pos, Color c, int kingFile) {
+    Bitboard ours = pos.pieces(c, PAWN) & (fileBB(kingFile) | adjacentFilesBB(kingFile));
+    Bitboard nearRank = rankBB(c == WHITE ? 1 : 6);
+    Bitboard farRank = rankBB(c == WHITE ? 2 : 5);
+    return ShieldNear * popcount(ours & nearRank) + ShieldFar * popcount(ours & farRank);
+}
+
+} // namespace
+
+void computePawnEntry(const Position& pos, PawnEntry& e) {
+    int mg = 0, eg = 0;
+    int bmg = 0, beg = 0;
+    evalPawns(pos, WHITE, mg, eg);
+    evalPawns(pos, BLACK, bmg, beg);
+    e.key = pos.pawnKey();
+    e.mg = (int16_t)(mg - bmg);
+    e.eg = (int16_t)(eg - beg);
+    for (int c = WHITE; c <= BLACK; c++) {
+        for (int f = 0; f < 8; f++) {
+            e.shield[c][f] = (uint8_t)pawnShield(pos, Color(c), f);
+        }
+    }
+    e.used = true;
+}
+
+PawnTable::PawnTable(int sizeLog2) : table(size_t(1) << sizeLog2), mask((uint64_t(1) << sizeLog2) - 1), hitCount(0), probeCount(0) {
+    clear();
+}
+
+void PawnTable::clear() {
+    for (PawnEntry& e : table) {
+        e = PawnEntry();
+    }
+    resetStats();
+}
+
+const PawnEntry& PawnTable::probe(const Position& pos) {
+    uint64_t key = pos.pawnKey();
+    PawnEntry& e = table[key & mask];
+    probeCount++;
+    if (e.used && e.key == key) {
+        hitCount++;
+        return e;
+    }
+    computePawnEntry(pos, e);
+    return e;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+#include "Position.h"
+
+// pawn terms of one pawn configuration, both colours. They depend only on
+// where the pawns stand, so they are cached by Position::pawnKey()
+struct PawnEntry {
+    uint64_t key;
+    int16_t mg;                    // white minus black: doubled, isolated,
+    int16_t eg;                    // backward and passed pawns
+    uint8_t shield[COLOR_NB][8];   // shelter for a king on its back ranks, by king file
+    bool used;
+};
+
+void computePawnEntry(const Position& pos, PawnEntry& e);
+
+// direct-mapped cache of pawn entries, one per searching thread so it needs
+// no locking; most moves leave the pawns alone and hit the cache
+class PawnTable {
+public:
+    explicit PawnTable(int sizeLog2 = 14);
+
+    const PawnEntry& probe(const Position& pos);
+    void clear();
+
+    // hit counters since the last resetStats()
+    uint64_t hits() const { return hitCount; }
+    uint64_t probes() const { return probeCount; }
+    double hitRate() const { return probeCount ? (double)hitCount / probeCount : 0.0; }
+    void resetStats() { hitCount = probeCount = 0; }
+
+private:
+    std::vector<PawnEntry> table;
+    uint64_t mask;
+    uint64_t hitCount;
+    uint64_t probeCount;
+};
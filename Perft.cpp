@@ -0,0 +1,172 @@
+// headless perft tool: counts leaf nodes of the legal move tree to validate
+// the rules code and measure its throughput
+//
+// usage: perft [depth] [--fen "<fen>"] [--threads N]
+//        perft --suite [--threads N]
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "MoveGen.h"
+
+using namespace std;
+
+// standard test positions with published node counts
+struct PerftCase {
+    const char* fen;
+    int depth;
+    uint64_t nodes;
+};
+
+static const PerftCase Suite[] = {
+    { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 6, 119060324ULL },
+    { "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 5, 193690690ULL },
+    { "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 7, 178633661ULL },
+    { "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 5, 15833292ULL },
+    { "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1", 5, 15833292ULL },
+    { "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 5, 89941194ULL },
+    { "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 5, 164075551ULL },
+};
+
+uint64_t perft(Position& pos, int depth) {
+    MoveList moves;
+    generateLegalMoves(pos, moves);
+    if (depth <= 1) {
+        return depth == 1 ? moves.size() : 1; // bulk count the last ply
+    }
+
+    uint64_t nodes = 0;
+    for (Move m : moves) {
+        pos.makeMove(m);
+        nodes += perft(pos, depth - 1);
+        pos.unmakeMove();
+    }
+    return nodes;
+}
+
+// splits the root moves over the threads, each with its own position copy;
+// fills counts[i] for moves[i] and returns the total
+uint64_t perftDivide(const Position& root, int depth, int threads, const MoveList& moves, vector<uint64_t>& counts) {
+    counts.assign(moves.size(), 0);
+    atomic<int> nextMove(0);
+
+    auto worker = [&]() {
+        Position pos = root;
+        int i;
+        while ((i = nextMove++) < moves.size()) {
+            pos.makeMove(moves[i]);
+            counts[i] = perft(pos, depth - 1);
+            pos.unmakeMove();
+        }
+    };
+
+    vector<thread> pool;
+    for (int t = 1; t < threads; t++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (thread& th : pool) {
+        th.join();
+    }
+
+    uint64_t total = 0;
+    for (uint64_t c : counts) {
+        total += c;
+    }
+    return total;
+}
+
+// runs one position, prints per move counts when divide is set
+uint64_t runPerft(const string& fen, int depth, int threads, bool divide, double& seconds) {
+    Position pos;
+    if (!pos.setFen(fen)) {
+        cout << "invalid fen: " << fen << endl;
+        seconds = 0;
+        return 0;
+    }
+
+    MoveList moves;
+    generateLegalMoves(pos, moves);
+    vector<uint64_t> counts;
+
+    auto start = chrono::steady_clock::now();
+    uint64_t total = depth <= 1 ? perft(pos, depth) : perftDivide(pos, depth, threads, moves, counts);
+    seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    if (divide) {
+        for (int i = 0; i < (int)counts.size(); i++) {
+            cout << moveToString(moves[i]) << ": " << counts[i] << "\n";
+        }
+    }
+    return total;
+}
+
+void printSpeed(uint64_t nodes, double seconds) {
+    cout << "Nodes: " << nodes << "  Time: " << (long long)(seconds * 1000) << " ms  NPS: "
+         << (long long)(seconds > 0 ? nodes / seconds : 0) << endl;
+}
+
+int main(int argc, char* argv[]) {
+    initBitboards();
+
+    string fen = StartFEN;
+    int depth = 5;
+    int threads = 1;
+    bool suite = false;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--fen" && i + 1 < argc) {
+            fen = argv[++i];
+        }
+        else if (arg == "--threads" && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+            if (threads == 0) {
+                threads = (int)thread::hardware_concurrency();
+            }
+        }
+        else if (arg == "--suite") {
+            suite = true;
+        }
+        else {
+            depth = atoi(arg.c_str());
+        }
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+
+    if (!suite) {
+        double seconds;
+        uint64_t nodes = runPerft(fen, depth, threads, true, seconds);
+        cout << endl;
+        printSpeed(nodes, seconds);
+        return 0;
+    }
+
+    // validation suite, non-zero exit code on any mismatch
+    int failed = 0;
+    uint64_t totalNodes = 0;
+    double totalTime = 0;
+    for (const PerftCase& pc : Suite) {
+        double seconds;
+        uint64_t nodes = runPerft(pc.fen, pc.depth, threads, false, seconds);
+        bool ok = nodes == pc.nodes;
+        failed += !ok;
+        totalNodes += nodes;
+        totalTime += seconds;
+        cout << (ok ? "ok    " : "FAIL  ") << "depth " << pc.depth << "  " << nodes;
+        if (!ok) {
+            cout << " (expected " << pc.nodes << ")";
+        }
+        cout << "  " << pc.fen << endl;
+    }
+    cout << endl;
+    printSpeed(totalNodes, totalTime);
+    cout << (failed ? "FAILED: " + to_string(failed) + " position(s)" : "all positions passed") << endl;
+    return failed ? 1 : 0;
+}
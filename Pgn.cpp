@@ -0,0 +1,447 @@
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include "MoveGen.h"
+#include "Pgn.h"
+
+using namespace std;
+
+const size_t BufferBytes = 16 << 20;  // buffered mode window, grows for a bigger game
+
+static bool isSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+// ends a movetext token
+static bool isDelimiter(char c) {
+    return isSpace(c) || c == '{' || c == '}' || c == '(' || c == ')' || c == ';' || c == '[' || c == ']' || c == '$';
+}
+
+static bool tokenIs(const char* p, size_t length, const char* word) {
+    return strlen(word) == length && memcmp(p, word, length) == 0;
+}
+
+const string* PgnGame::tag(const char* name) const {
+    for (int i = 0; i < tagCount; i++) {
+        if (tags[i].name == name) {
+            return &tags[i].value;
+        }
+    }
+    return nullptr;
+}
+
+bool PgnGame::startPosition(Position& pos) const {
+    if (fen.empty()) {
+        pos.setStartPosition();
+        return true;
+    }
+    return pos.setFen(fen);
+}
+
+PgnReader::PgnReader()
+    : data(nullptr), dataSize(0), file(nullptr), start(nullptr), cur(nullptr), limit(nullptr),
+      base(0), rangeEnd(0), atEnd(true) {}
+
+bool PgnReader::open(const string& path) {
+    close();
+    startPos.setStartPosition();
+    if (map.open(path)) {
+        map.adviseSequential();
+        openMemory(map.data(), map.size());
+        return true;
+    }
+    // not mappable (pipe, 32-bit address space): one big buffer instead
+    file = fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    buffer.resize(BufferBytes);
+    start = cur = limit = buffer.data();
+    base = 0;
+    rangeEnd = UINT64_MAX;
+    atEnd = false;
+    return true;
+}
+
+void PgnReader::openMemory(const char* mem, uint64_t size) {
+    startPos.setStartPosition();
+    data = mem;
+    dataSize = size;
+    setRange(0, size);
+}
+
+void PgnReader::close() {
+    map.close();
+    if (file) {
+        fclose(file);
+        file = nullptr;
+    }
+    data = nullptr;
+    dataSize = 0;
+    start = cur = limit = nullptr;
+    base = 0;
+    atEnd = true;
+}
+
+void PgnReader::setRange(uint64_t begin, uint64_t end) {
+    if (file) {
+        seekFile(file, begin, SEEK_SET);
+        start = cur = limit = buffer.data();
+        base = begin;
+        rangeEnd = end;
+        atEnd = false;
+        return;
+    }
+    end = min(end, dataSize);
+    begin = min(begin, end);
+    start = cur = data + begin;
+    limit = data + end;
+    base = begin;
+    rangeEnd = end;
+    atEnd = true;
+}
+
+// buffered mode: keep the unparsed tail (the game being parsed) and read
+// behind it; false when nothing more can be read
+bool PgnReader::refill() {
+    if (!file || atEnd) {
+        return false;
+    }
+    size_t keep = limit - cur;
+    base += cur - buffer.data();
+    memmove(buffer.data(), cur, keep);
+    if (keep == buffer.size()) {
+        buffer.resize(buffer.size() * 2); // one game bigger than the window
+    }
+    uint64_t offset = base + keep;
+    size_t want = buffer.size() - keep;
+    if (rangeEnd - offset < want) {
+        want = size_t(rangeEnd - offset);
+    }
+    size_t got = want ? fread(buffer.data() + keep, 1, want, file) : 0;
+    start = cur = buffer.data();
+    limit = start + keep + got;
+    if (got < want || offset + got >= rangeEnd) {
+        atEnd = true;
+    }
+    return true;
+}
+
+bool PgnReader::next(PgnGame& game) {
+    while (true) {
+        ParseStatus status = parseGame(game);
+        if (status == PARSE_GAME) {
+            return true;
+        }
+        if (status == PARSE_END || !refill()) {
+            return false;
+        }
+    }
+}
+
+// parses one game from cur; cur only moves once the game is complete, so a
+// game cut by the end of the buffer is parsed again after a refill
+PgnReader::ParseStatus PgnReader::parseGame(PgnGame& game) {
+    const char* p = cur;
+    const char* e = limit;
+
+    // a UTF-8 BOM at the start of the file
+    if (base + (uint64_t)(p - start) == 0 && e - p >= 3 && memcmp(p, "\xEF\xBB\xBF", 3) == 0) {
+        p += 3;
+    }
+
+    // blank lines and escape lines ('%' at a line start)
+    while (true) {
+        while (p < e && isSpace(*p)) {
+            p++;
+        }
+        if (p < e && *p == '%') {
+            while (p < e && *p != '\n') {
+                p++;
+            }
+            continue;
+        }
+        break;
+    }
+    if (p == e) {
+        if (atEnd) {
+            cur = p;
+            return PARSE_END;
+        }
+        return PARSE_NEED_MORE;
+    }
+
+    game.tagCount = 0;
+    game.fen.clear();
+    game.moves.clear();
+    game.result = PGN_UNKNOWN;
+    game.error.clear();
+    game.offset = base + (uint64_t)(p - start);
+
+    // tag pairs: [Name "value"]
+    while (p < e && *p == '[') {
+        p++;
+        while (p < e && isSpace(*p)) {
+            p++;
+        }
+        const char* name = p;
+        while (p < e && !isSpace(*p) && *p != '"' && *p != ']') {
+            p++;
+        }
+        const char* nameEnd = p;
+        while (p < e && *p != '"' && *p != ']' && *p != '\n') {
+            p++;
+        }
+        if ((int)game.tags.size() == game.tagCount) {
+            game.tags.emplace_back();
+        }
+        PgnTag& tag = game.tags[game.tagCount++];
+        tag.name.assign(name, nameEnd);
+        tag.value.clear();
+        if (p < e && *p == '"') {
+            p++;
+            while (p < e && *p != '"') {
+                if (*p == '\\' && p + 1 < e) {
+                    p++;
+                }
+                tag.value += *p++;
+            }
+        }
+        while (p < e && *p != ']' && *p != '\n') {
+            p++;
+        }
+        if (p < e && *p == ']') {
+            p++;
+        }
+        while (p < e && isSpace(*p)) {
+            p++;
+        }
+        if (p == e && !atEnd) {
+            return PARSE_NEED_MORE;
+        }
+        if (tag.name == "FEN") {
+            game.fen = tag.value;
+        }
+    }
+
+    bool bad = false;
+    if (game.fen.empty()) {
+        pos = startPos;
+    }
+    else if (!pos.setFen(game.fen)) {
+        game.error = "bad FEN";
+        bad = true;
+    }
+
+    // movetext up to the result, or up to the next game's tags
+    while (true) {
+        while (p < e && isSpace(*p)) {
+            p++;
+        }
+        if (p == e) {
+            if (!atEnd) {
+                return PARSE_NEED_MORE;
+            }
+            break;
+        }
+
+        char c = *p;
+        if (c == '[') {
+            break; // next game, this one had no result
+        }
+        if (c == '{' || c == ';' || c == '%') {
+            const char* q = (const char*)memchr(p, c == '{' ? '}' : '\n', e - p);
+            if (!q) {
+                if (!atEnd) {
+                    return PARSE_NEED_MORE;
+                }
+                q = e - 1;
+            }
+            p = q + 1;
+            continue;
+        }
+        if (c == '(') {
+            // variation, nested, with comments that may hold brackets
+            int depth = 0;
+            while (p < e) {
+                if (*p == '{' || *p == ';') {
+                    const char* q = (const char*)memchr(p, *p == '{' ? '}' : '\n', e - p);
+                    p = q ? q : e;
+                    if (p == e) {
+                        break;
+                    }
+                }
+                else if (*p == '(') {
+                    depth++;
+                }
+                else if (*p == ')' && --depth == 0) {
+                    p++;
+                    break;
+                }
+                p++;
+            }
+            if (depth > 0 && !atEnd) {
+                return PARSE_NEED_MORE;
+            }
+            continue;
+        }
+        if (c == ')' || c == ']' || c == '}') {
+            p++;
+            continue;
+        }
+        if (c == '$') {
+            p++;
+        }
+
+        const char* q = p;
+        while (q < e && !isDelimiter(*q)) {
+            q++;
+        }
+        if (q == e && !atEnd) {
+            return PARSE_NEED_MORE;
+        }
+        size_t length = q - p;
+        const char* token = p;
+        p = q;
+        if (c == '$' || length == 0) {
+            continue; // NAG
+        }
+
+        // game termination marker
+        if (tokenIs(token, length, "1-0")) { game.result = PGN_WHITE_WINS; break; }
+        if (tokenIs(token, length, "0-1")) { game.result = PGN_BLACK_WINS; break; }
+        if (tokenIs(token, length, "1/2-1/2")) { game.result = PGN_DRAW; break; }
+        if (tokenIs(token, length, "*")) { break; }
+
+        // move number "12." / "12..." / "...", possibly glued to the move
+        if ((*token >= '1' && *token <= '9') || *token == '.') {
+            const char* t = token;
+            while (t < q && *t >= '0' && *t <= '9') {
+                t++;
+            }
+            const char* dots = t;
+            while (t < q && *t == '.') {
+                t++;
+            }
+            if (t == q || t == dots) {
+                continue;
+            }
+            length -= t - token;
+            token = t;
+        }
+        if (bad || tokenIs(token, length, "e.p.")) {
+            continue;
+        }
+
+        Move m = parseSan(pos, token, length);
+        if (m == MOVE_NONE) {
+            // the rest of the game is skipped, the moves up to here stay
+            game.error = "illegal move " + string(token, length) + " at ply " + to_string(game.moves.size() + 1);
+            bad = true;
+            continue;
+        }
+        game.moves.push_back(m);
+        pos.makeMove(m);
+    }
+    cur = p;
+    return PARSE_GAME;
+}
+
+// first game start at or after offset: a '[' opening a line after a blank
+// line; the file size if there is none
+static uint64_t findGameStart(FILE* f, uint64_t offset, uint64_t size) {
+    char chunk[1 << 16];
+    seekFile(f, offset, SEEK_SET);
+    int lineBreaks = 0;
+    bool lineStart = false;
+    while (offset < size) {
+        size_t got = fread(chunk, 1, sizeof(chunk), f);
+        if (got == 0) {
+            break;
+        }
+        for (size_t i = 0; i < got; i++) {
+            char c = chunk[i];
+            if (c == '\n') {
+                lineBreaks++;
+                lineStart = true;
+            }
+            else if (c == '[' && lineStart && lineBreaks >= 2) {
+                return offset + i;
+            }
+            else if (c != '\r' && c != ' ' && c != '\t') {
+                lineBreaks = 0;
+                lineStart = false;
+            }
+        }
+        offset += got;
+    }
+    return size;
+}
+
+vector<uint64_t> splitPgn(const string& path, int parts) {
+    vector<uint64_t> cuts;
+    cuts.push_back(0);
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) {
+        cuts.push_back(0);
+        return cuts;
+    }
+    // a pipe has no size: one range to the end of the data
+    if (seekFile(f, 0, SEEK_END) != 0) {
+        fclose(f);
+        cuts.push_back(UINT64_MAX);
+        return cuts;
+    }
+    uint64_t size = tellFile(f);
+    for (int i = 1; i < parts; i++) {
+        uint64_t target = size / parts * i;
+        if (target <= cuts.back()) {
+            continue;
+        }
+        uint64_t cut = findGameStart(f, target, size);
+        if (cut >= size) {
+            break;
+        }
+        cuts.push_back(cut);
+    }
+    cuts.push_back(size);
+    fclose(f);
+    return cuts;
+}
+
+PgnStats readPgnParallel(const string& path, int threads, const function<void(int, const PgnGame&)>& onGame) {
+    if (threads <= 0) {
+        threads = max(1u, thread::hardware_concurrency());
+    }
+    vector<uint64_t> cuts = splitPgn(path, threads);
+    int parts = (int)cuts.size() - 1;
+    vector<PgnStats> perThread(parts);
+    vector<thread> workers;
+    for (int i = 0; i < parts; i++) {
+        workers.emplace_back([&, i] {
+            PgnReader reader;
+            if (!reader.open(path)) {
+                return;
+            }
+            reader.setRange(cuts[i], cuts[i + 1]);
+            PgnGame game;
+            PgnStats& st = perThread[i];
+            while (reader.next(game)) {
+                st.games++;
+                st.moves += game.moves.size();
+                st.errors += !game.error.empty();
+                onGame(i, game);
+            }
+            st.bytes = reader.bytesParsed() - cuts[i];
+        });
+    }
+    PgnStats total;
+    for (int i = 0; i < parts; i++) {
+        workers[i].join();
+        total.games += perThread[i].games;
+        total.moves += perThread[i].moves;
+        total.errors += perThread[i].errors;
+        total.bytes += perThread[i].bytes;
+    }
+    return total;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+#include "Position.h"
+
+enum PgnResult : uint8_t {
+    PGN_WHITE_WINS,
+    PGN_BLACK_WINS,
+    PGN_DRAW,
+    PGN_UNKNOWN  // "*" or no result
+};
+
+struct PgnTag {
+    std::string name;
+    std::string value;
+};
+
+// one game from a PGN file. The reader refills the same object for every
+// game, so the strings and vectors keep their capacity and a long import
+// does not allocate per game.
+struct PgnGame {
+    std::vector<PgnTag> tags;  // first tagCount entries are this game's
+    int tagCount = 0;
+    std::string fen;           // FEN tag, empty for the standard start
+    std::vector<Move> moves;   // main line, every move checked legal
+    PgnResult result = PGN_UNKNOWN;
+    std::string error;         // why the moves stop early, empty if they don't
+    uint64_t offset = 0;       // byte offset of the game in the file
+
+    const std::string* tag(const char* name) const;
+    // start position of the game, false for a bad FEN tag
+    bool startPosition(Position& pos) const;
+};
+
+// streaming PGN reader: the file is mapped, or read through one large
+// buffer when it can't be, and games are parsed straight out of it. SAN
+// moves are resolved against the legal move generator; variations,
+// comments, NAGs and move numbers are skipped.
+class PgnReader {
+public:
+    PgnReader();
+
+    bool open(const std::string& path);
+    // parse size bytes at data (not copied, must outlive the reader)
+    void openMemory(const char* data, uint64_t size);
+    void close();
+
+    // read only bytes [begin, end) of the file; begin must be the start of
+    // a game (see splitPgn). Call after open().
+    void setRange(uint64_t begin, uint64_t end);
+
+    // next game, false at the end
+    bool next(PgnGame& game);
+
+    uint64_t bytesParsed() const { return base + (uint64_t)(cur - start); }
+
+private:
+    enum ParseStatus { PARSE_GAME, PARSE_NEED_MORE, PARSE_END };
+
+    ParseStatus parseGame(PgnGame& game);
+    bool refill();
+
+    MappedFile map;
+    const char* data;          // whole mapped file or memory buffer
+    uint64_t dataSize;
+    FILE* file;                // buffered mode when set
+    std::vector<char> buffer;
+    const char* start;         // data window: [start, limit)
+    const char* cur;
+    const char* limit;
+    uint64_t base;             // file offset of start
+    uint64_t rangeEnd;
+    bool atEnd;                // limit is the end of the data
+    Position startPos;         // copied per game, cheaper than parsing FEN
+    Position pos;
+};
+
+// byte offsets splitting the file into at most parts ranges that each start
+// at a game: a '[' at the start of a line after a blank line. The last
+// entry is the file size (UINT64_MAX for a pipe, which is not split).
+std::vector<uint64_t> splitPgn(const std::string& path, int parts);
+
+struct PgnStats {
+    uint64_t games = 0;
+    uint64_t moves = 0;
+    uint64_t errors = 0;  // games with an unresolved move or a bad FEN
+    uint64_t bytes = 0;
+};
+
+// parses the file with threads readers on ranges from splitPgn; onGame runs
+// on the reader threads, concurrently, with the thread's index
+PgnStats readPgnParallel(const std::string& path, int threads,
+                         const std::function<void(int, const PgnGame&)>& onGame);
@@ -0,0 +1,577 @@
+#include <algorithm>
+#include <sstream>
+#include "Evaluate.h"
+#include "Position.h"
+
+using namespace std;
+
+static const char PieceChars[] = "PNBRQKpnbrqk";
+
+namespace Zobrist {
+uint64_t psq[PIECE_NB][64];
+uint64_t enpassant[8];
+uint64_t castling[16];
+uint64_t side;
+}
+
+// fill the zobrist keys before main() runs, fixed seed so keys are stable
+static struct ZobristInit {
+    ZobristInit() {
+        uint64_t s = 1070372;
+        auto rand64 = [&s]() {
+            // splitmix64
+            uint64_t z = (s += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            return z ^ (z >> 31);
+        };
+        for (int pc = 0; pc < PIECE_NB; pc++) {
+            for (int sq = 0; sq < 64; sq++) {
+                Zobrist::psq[pc][sq] = rand64();
+            }
+        }
+        for (int f = 0; f < 8; f++) {
+            Zobrist::enpassant[f] = rand64();
+        }
+        // one key per right, combined rights xor their parts
+        uint64_t rightKeys[4] = { rand64(), rand64(), rand64(), rand64() };
+        for (int cr = 0; cr < 16; cr++) {
+            Zobrist::castling[cr] = 0;
+            for (int i = 0; i < 4; i++) {
+                if (cr & (1 << i)) {
+                    Zobrist::castling[cr] ^= rightKeys[i];
+                }
+            }
+        }
+        Zobrist::side = rand64();
+    }
+} zobristInit;
+
+// rights lost when a piece leaves or lands on a square
+static int castlingMask(Square s) {
+    switch (s) {
+    case 0: return WHITE_OOO;              // a1
+    case 4: return WHITE_OO | WHITE_OOO;   // e1
+    case 7: return WHITE_OO;               // h1
+    case 56: return BLACK_OOO;             // a8
+    case 60: return BLACK_OO | BLACK_OOO;  // e8
+    case 63: return BLACK_OO;              // h8
+    default: return 0;
+    }
+}
+
+Piece pieceFromChar(char c) {
+    for (int i = 0; i < PIECE_NB; i++) {
+        if (PieceChars[i] == c) {
+            return Piece(i);
+        }
+    }
+    return NO_PIECE;
+}
+
+char pieceToChar(Piece pc) {
+    return pc == NO_PIECE ? ' ' : PieceChars[pc];
+}
+
+int getPieceValue(Piece pc) {
+    static const int values[PIECE_TYPE_NB] = { 1, 3, 3, 5, 9, 0 };
+    return pc == NO_PIECE ? 0 : values[typeOf(pc)];
+}
+
+Position::Position() {
+    clear();
+}
+
+void Position::clear() {
+    for (int i = 0; i < PIECE_NB; i++) {
+        byPiece[i] = 0;
+        pieceCount[i] = 0;
+    }
+    byColor[WHITE] = byColor[BLACK] = 0;
+    occupied = 0;
+    for (int s = 0; s < 64; s++) {
+        board[s] = NO_PIECE;
+    }
+    kingSq[WHITE] = kingSq[BLACK] = NO_SQUARE;
+    side = WHITE;
+    castling = 0;
+    epSq = NO_SQUARE;
+    rule50 = 0;
+    ply = 0;
+    hashKey = 0;
+    pawnHashKey = 0;
+    mgScore = egScore = phaseWeight = 0;
+    checkersBB = pinnedBB = 0;
+    history.clear();
+}
+
+void Position::setStartPosition() {
+    setFen(StartFEN);
+}
+
+bool Position::setFen(const string& fen) {
+    clear();
+    istringstream ss(fen);
+    string placement, stm, rights, ep;
+    int halfmove = 0, fullmove = 1;
+    if (!(ss >> placement >> stm)) {
+        return false;
+    }
+    ss >> rights >> ep >> halfmove >> fullmove; // optional fields
+
+    // piece placement, rank 8 first; every rank must fill exactly 8 files
+    int rank = 7, file = 0;
+    for (char c : placement) {
+        bool ok;
+        if (c == '/') {
+            ok = file == 8 && rank > 0;
+            rank--;
+            file = 0;
+        }
+        else if (c >= '1' && c <= '8') {
+            file += c - '0';
+            ok = file <= 8;
+        }
+        else {
+            Piece pc = pieceFromChar(c);
+            ok = pc != NO_PIECE && file < 8;
+            if (ok) {
+                putPiece(pc, makeSquare(file, rank));
+                file++;
+            }
+        }
+        if (!ok) {
+            clear();
+            return false;
+        }
+    }
+    if (rank != 0 || file != 8
+        || count(W_KING) != 1 || count(B_KING) != 1 || (stm != "w" && stm != "b")) {
+        clear();
+        return false;
+    }
+
+    if (stm == "b") {
+        side = BLACK;
+        hashKey ^= Zobrist::side;
+    }
+    // the side that just moved cannot have left its king in check
+    if (attackersTo(kingSquare(~side)) & pieces(side)) {
+        clear();
+        return false;
+    }
+
+    int cr = 0;
+    for (char c : rights) {
+        if (c == 'K') { cr |= WHITE_OO; }
+        if (c == 'Q') { cr |= WHITE_OOO; }
+        if (c == 'k') { cr |= BLACK_OO; }
+        if (c == 'q') { cr |= BLACK_OOO; }
+    }
+    // drop rights whose king or rook is not at home
+    if (pieceOn(4) != W_KING) { cr &= ~(WHITE_OO | WHITE_OOO); }
+    if (pieceOn(7) != W_ROOK) { cr &= ~WHITE_OO; }
+    if (pieceOn(0) != W_ROOK) { cr &= ~WHITE_OOO; }
+    if (pieceOn(60) != B_KING) { cr &= ~(BLACK_OO | BLACK_OOO); }
+    if (pieceOn(63) != B_ROOK) { cr &= ~BLACK_OO; }
+    if (pieceOn(56) != B_ROOK) { cr &= ~BLACK_OOO; }
+    setCastling(cr);
+
+    // same rule as makeMove: only keep a capturable en passant square
+    if (ep.size() == 2 && ep[0] >= 'a' && ep[0] <= 'h' && (ep[1] == '3' || ep[1] == '6')) {
+        Square s = makeSquare(ep[0] - 'a', ep[1] - '1');
+        if (PawnAttacks[~side][s] & pieces(side, PAWN)) {
+            setEpSquare(s);
+        }
+    }
+
+    rule50 = halfmove;
+    ply = 2 * (fullmove > 0 ? fullmove - 1 : 0) + (side == BLACK);
+    updateCheckInfo();
+    history.reserve(256);
+    return true;
+}
+
+// operands of opcode in an EPD operations string, empty if absent
+static string epdOperand(const string& ops, const string& opcode) {
+    size_t i = 0;
+    while (i < ops.size()) {
+        size_t end = ops.find(';', i);
+        if (end == string::npos) {
+            end = ops.size();
+        }
+        istringstream op(ops.substr(i, end - i));
+        string code, operand;
+        if (op >> code && code == opcode && op >> operand) {
+            return operand;
+        }
+        i = end + 1;
+    }
+    return "";
+}
+
+bool Position::setEpd(const string& epd, string* ops) {
+    istringstream ss(epd);
+    string placement, stm, rights, ep;
+    if (!(ss >> placement >> stm >> rights >> ep)) {
+        clear();
+        return false;
+    }
+    string rest;
+    getline(ss, rest);
+    size_t first = rest.find_first_not_of(' ');
+    rest = first == string::npos ? "" : rest.substr(first);
+
+    string halfmove = epdOperand(rest, "hmvc"), fullmove = epdOperand(rest, "fmvn");
+    string fen = placement + " " + stm + " " + rights + " " + ep + " "
+        + (halfmove.empty() ? "0" : halfmove) + " " + (fullmove.empty() ? "1" : fullmove);
+    if (ops) {
+        *ops = rest;
+    }
+    return setFen(fen);
+}
+
+string Position::epd(const string& ops) const {
+    // fen() without the two clock fields
+    string out = fen();
+    out.erase(out.rfind(' ', out.rfind(' ') - 1));
+    if (!ops.empty()) {
+        out += ' ';
+        out += ops;
+    }
+    return out;
+}
+
+void Position::pack(PackedPosition& pp) const {
+    for (int i = 0; i < 32; i++) {
+        pp.board[i] = uint8_t(board[2 * i] | (board[2 * i + 1] << 4));
+    }
+    pp.side = uint8_t(side);
+    pp.castling = uint8_t(castling);
+    pp.epSq = uint8_t(epSq);
+    pp.rule50 = uint8_t(min(rule50, 255));
+    pp.ply = uint16_t(ply);
+}
+
+void Position::unpack(const PackedPosition& pp) {
+    clear();
+    for (int s = 0; s < 64; s++) {
+        Piece pc = Piece((pp.board[s / 2] >> (4 * (s & 1))) & 15);
+        if (pc != NO_PIECE) {
+            putPiece(pc, Square(s));
+        }
+    }
+    if (pp.side == BLACK) {
+        side = BLACK;
+        hashKey ^= Zobrist::side;
+    }
+    setCastling(pp.castling);
+    if (pp.epSq != NO_SQUARE) {
+        setEpSquare(Square(pp.epSq));
+    }
+    rule50 = pp.rule50;
+    ply = pp.ply;
+    updateCheckInfo();
+}
+
+string Position::fen() const {
+    string out = "";
+    for (int rank = 7; rank >= 0; rank--) {
+        int emptyRun = 0;
+        for (int file = 0; file < 8; file++) {
+            Piece pc = board[makeSquare(file, rank)];
+            if (pc == NO_PIECE) {
+                emptyRun++;
+                continue;
+            }
+            if (emptyRun) {
+                out += char('0' + emptyRun);
+                emptyRun = 0;
+            }
+            out += pieceToChar(pc);
+        }
+        if (emptyRun) {
+            out += char('0' + emptyRun);
+        }
+        if (rank > 0) {
+            out += '/';
+        }
+    }
+
+    out += side == WHITE ? " w " : " b ";
+    if (castling & WHITE_OO) { out += 'K'; }
+    if (castling & WHITE_OOO) { out += 'Q'; }
+    if (castling & BLACK_OO) { out += 'k'; }
+    if (castling & BLACK_OOO) { out += 'q'; }
+    if (!castling) { out += '-'; }
+
+    out += ' ';
+    if (epSq == NO_SQUARE) {
+        out += '-';
+    }
+    else {
+        out += char('a' + fileOf(epSq));
+        out += char('1' + rankOf(epSq));
+    }
+
+    out += " " + to_string(rule50) + " " + to_string(1 + ply / 2);
+    return out;
+}
+
+void Position::setCastling(int rights) {
+    hashKey ^= Zobrist::castling[castling] ^ Zobrist::castling[rights];
+    castling = rights;
+}
+
+void Position::setEpSquare(Square s) {
+    if (epSq != NO_SQUARE) {
+        hashKey ^= Zobrist::enpassant[fileOf(epSq)];
+    }
+    epSq = s;
+    if (epSq != NO_SQUARE) {
+        hashKey ^= Zobrist::enpassant[fileOf(epSq)];
+    }
+}
+
+void Position::putPiece(Piece pc, Square s) {
+    Bitboard b = squareBB(s);
+    board[s] = pc;
+    byPiece[pc] |= b;
+    byColor[colorOf(pc)] |= b;
+    occupied |= b;
+    pieceCount[pc]++;
+    hashKey ^= Zobrist::psq[pc][s];
+    if (typeOf(pc) == PAWN) {
+        pawnHashKey ^= Zobrist::psq[pc][s];
+    }
+    mgScore += PsqMg[pc][s];
+    egScore += PsqEg[pc][s];
+    phaseWeight += PhaseWeight[typeOf(pc)];
+    if (typeOf(pc) == KING) {
+        kingSq[colorOf(pc)] = s;
+    }
+}
+
+void Position::removePiece(Square s) {
+    Piece pc = board[s];
+    if (pc == NO_PIECE) {
+        return;
+    }
+    Bitboard b = squareBB(s);
+    byPiece[pc] ^= b;
+    byColor[colorOf(pc)] ^= b;
+    occupied ^= b;
+    pieceCount[pc]--;
+    hashKey ^= Zobrist::psq[pc][s];
+    if (typeOf(pc) == PAWN) {
+        pawnHashKey ^= Zobrist::psq[pc][s];
+    }
+    mgScore -= PsqMg[pc][s];
+    egScore -= PsqEg[pc][s];
+    phaseWeight -= PhaseWeight[typeOf(pc)];
+    board[s] = NO_PIECE;
+    if (typeOf(pc) == KING) {
+        kingSq[colorOf(pc)] = NO_SQUARE;
+    }
+}
+
+// destination must be empty
+void Position::movePiece(Square from, Square to) {
+    Piece pc = board[from];
+    Bitboard fromTo = squareBB(from) | squareBB(to);
+    byPiece[pc] ^= fromTo;
+    byColor[colorOf(pc)] ^= fromTo;
+    occupied ^= fromTo;
+    board[from] = NO_PIECE;
+    board[to] = pc;
+    hashKey ^= Zobrist::psq[pc][from] ^ Zobrist::psq[pc][to];
+    if (typeOf(pc) == PAWN) {
+        pawnHashKey ^= Zobrist::psq[pc][from] ^ Zobrist::psq[pc][to];
+    }
+    mgScore += PsqMg[pc][to] - PsqMg[pc][from];
+    egScore += PsqEg[pc][to] - PsqEg[pc][from];
+    if (typeOf(pc) == KING) {
+        kingSq[colorOf(pc)] = to;
+    }
+}
+
+void Position::makeMove(Move m) {
+    Color us = side;
+    Color them = ~us;
+    Square from = fromSq(m);
+    Square to = toSq(m);
+    Piece pc = board[from];
+    Piece captured = capturedBy(m);
+
+    // save what cannot be recomputed cheaply
+    UndoInfo u;
+    u.key = hashKey;
+    u.checkers = checkersBB;
+    u.pinned = pinnedBB;
+    u.move = m;
+    u.captured = (uint8_t)captured;
+    u.castling = (uint8_t)castling;
+    u.epSq = (uint8_t)epSq;
+    u.rule50 = (uint16_t)rule50;
+
+    // board changes, for evaluators that update incrementally
+    u.dirtyCount = 0;
+    auto dirty = [&u](Piece p, Square f, Square t) {
+        u.dirty[u.dirtyCount++] = { (uint8_t)p, (uint8_t)f, (uint8_t)t };
+    };
+    if (typeOfMove(m) == CASTLING) {
+        bool kingSide = to > from;
+        dirty(pc, from, to);
+        dirty(makePiece(us, ROOK), kingSide ? from + 3 : from - 4, kingSide ? from + 1 : from - 1);
+    }
+    else {
+        if (captured != NO_PIECE) {
+            dirty(captured, typeOfMove(m) == EN_PASSANT ? (us == WHITE ? to - 8 : to + 8) : to, NO_SQUARE);
+        }
+        if (typeOfMove(m) == PROMOTION) {
+            dirty(pc, from, NO_SQUARE);
+            dirty(makePiece(us, promotionType(m)), NO_SQUARE, to);
+        }
+        else {
+            dirty(pc, from, to);
+        }
+    }
+    history.push_back(u);
+
+    setEpSquare(NO_SQUARE);
+
+    if (typeOfMove(m) == CASTLING) {
+        // king moves two squares, rook jumps over it
+        bool kingSide = to > from;
+        Square rookFrom = kingSide ? from + 3 : from - 4;
+        Square rookTo = kingSide ? from + 1 : from - 1;
+        movePiece(from, to);
+        movePiece(rookFrom, rookTo);
+    }
+    else {
+        if (captured != NO_PIECE) {
+            Square capSq = typeOfMove(m) == EN_PASSANT ? (us == WHITE ? to - 8 : to + 8) : to;
+            removePiece(capSq);
+        }
+        movePiece(from, to);
+
+        if (typeOfMove(m) == PROMOTION) {
+            removePiece(to);
+            putPiece(makePiece(us, promotionType(m)), to);
+        }
+
+        // en passant square only when an enemy pawn can really take
+        if (typeOf(pc) == PAWN && (to ^ from) == 16) {
+            Square ep = (from + to) / 2;
+            if (PawnAttacks[us][ep] & pieces(them, PAWN)) {
+                setEpSquare(ep);
+            }
+        }
+    }
+
+    setCastling(castling & ~(castlingMask(from) | castlingMask(to)));
+    rule50 = (typeOf(pc) == PAWN || captured != NO_PIECE) ? 0 : rule50 + 1;
+    ply++;
+    side = them;
+    hashKey ^= Zobrist::side;
+    updateCheckInfo();
+}
+
+void Position::unmakeMove() {
+    const UndoInfo& u = history.back();
+    Move m = u.move;
+    Square from = fromSq(m);
+    Square to = toSq(m);
+
+    side = ~side;
+    Color us = side;
+
+    if (typeOfMove(m) == CASTLING) {
+        bool kingSide = to > from;
+        movePiece(to, from);
+        movePiece(kingSide ? from + 1 : from - 1, kingSide ? from + 3 : from - 4);
+    }
+    else {
+        if (typeOfMove(m) == PROMOTION) {
+            removePiece(to);
+            putPiece(makePiece(us, PAWN), to);
+        }
+        movePiece(to, from);
+        if (u.captured != NO_PIECE) {
+            Square capSq = typeOfMove(m) == EN_PASSANT ? (us == WHITE ? to - 8 : to + 8) : to;
+            putPiece(Piece(u.captured), capSq);
+        }
+    }
+
+    // the board edits above touched the key, the saved one wins
+    hashKey = u.key;
+    checkersBB = u.checkers;
+    pinnedBB = u.pinned;
+    castling = u.castling;
+    epSq = u.epSq;
+    rule50 = u.rule50;
+    ply--;
+    history.pop_back();
+}
+
+bool Position::isRepetition() const {
+    // same side to move every two plies, stop at the last irreversible move
+    int n = (int)history.size();
+    int limit = rule50 < n ? rule50 : n;
+    for (int i = 4; i <= limit; i += 2) {
+        if (history[n - i].key == hashKey) {
+            return true;
+        }
+    }
+    return false;
+}
+
+Piece Position::capturedBy(Move m) const {
+    if (typeOfMove(m) == EN_PASSANT) {
+        return makePiece(~side, PAWN);
+    }
+    if (typeOfMove(m) == CASTLING) {
+        return NO_PIECE;
+    }
+    return board[toSq(m)];
+}
+
+void Position::updateCheckInfo() {
+    Color us = side;
+    Color them = ~us;
+    Square k = kingSq[us];
+    checkersBB = pinnedBB = 0;
+    if (k == NO_SQUARE) {
+        return;
+    }
+
+    checkersBB = attackersTo(k) & byColor[them];
+
+    // enemy sliders lined up with our king with exactly one piece between;
+    // if that piece is ours it is pinned
+    Bitboard snipers = (rookAttacks(k, 0) & (pieces(them, ROOK) | pieces(them, QUEEN)))
+                     | (bishopAttacks(k, 0) & (pieces(them, BISHOP) | pieces(them, QUEEN)));
+    while (snipers) {
+        Bitboard b = betweenBB(k, popLsb(snipers)) & occupied;
+        if (b && !moreThanOne(b) && (b & byColor[us])) {
+            pinnedBB |= b;
+        }
+    }
+}
+
+Bitboard Position::attackersTo(Square s, Bitboard occ) const {
+    return (PawnAttacks[BLACK][s] & byPiece[W_PAWN])
+         | (PawnAttacks[WHITE][s] & byPiece[B_PAWN])
+         | (KnightAttacks[s] & pieces(KNIGHT))
+         | (bishopAttacks(s, occ) & (pieces(BISHOP) | pieces(QUEEN)))
+         | (rookAttacks(s, occ) & (pieces(ROOK) | pieces(QUEEN)))
+         | (KingAttacks[s] & pieces(KING));
+}
+
+void Position::toBoardView(char view[8][8]) const {
+    for (int r = 0; r < 8; r++) {
+        for (int c = 0; c < 8; c++) {
+            view[r][c] = pieceToChar(board[squareAt(r, c)]);
+        }
+    }
+}
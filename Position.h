@@ -0,0 +1,181 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "Bitboard.h"
+#include "Move.h"
+
+enum CastlingRight {
+    WHITE_OO = 1,
+    WHITE_OOO = 2,
+    BLACK_OO = 4,
+    BLACK_OOO = 8,
+    ALL_CASTLING = 15
+};
+
+// random keys for position hashing, filled once at program start
+namespace Zobrist {
+extern uint64_t psq[PIECE_NB][64];
+extern uint64_t enpassant[8];
+extern uint64_t castling[16];
+extern uint64_t side;
+}
+
+const char* const StartFEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// piece <-> board character ('P' white pawn, 'p' black pawn, ' ' empty)
+Piece pieceFromChar(char c);
+char pieceToChar(Piece pc);
+
+// material value used for the score (pawn = 1 ... queen = 9, king = 0)
+int getPieceValue(Piece pc);
+
+// one piece changed by a move: from = NO_SQUARE when it was added,
+// to = NO_SQUARE when it was removed
+struct DirtyPiece {
+    uint8_t piece;
+    uint8_t from;
+    uint8_t to;
+};
+
+// what makeMove() overwrites, enough for unmakeMove() to restore it,
+// plus the pieces the move changed (at most 3: castling, capture-promotion)
+struct UndoInfo {
+    uint64_t key;
+    Bitboard checkers;
+    Bitboard pinned;
+    Move move;
+    uint8_t captured;
+    uint8_t castling;
+    uint8_t epSq;
+    uint16_t rule50;
+    uint8_t dirtyCount;
+    DirtyPiece dirty[3];
+};
+
+// a position in 38 bytes without bitboards or move history, for keeping
+// many games in memory; two squares per byte (low nibble = even square)
+struct PackedPosition {
+    uint8_t board[32];
+    uint8_t side;
+    uint8_t castling;
+    uint8_t epSq;
+    uint8_t rule50;
+    uint16_t ply;
+};
+
+static_assert(sizeof(PackedPosition) == 38, "packed position is 38 bytes");
+
+// bitboard position: one bitboard per piece, per colour and for all pieces,
+// plus a mailbox, king squares and piece counts kept in sync with them
+class Position {
+public:
+    Position();
+
+    void clear();
+    void setStartPosition();
+
+    // FEN import/export, setFen returns false (position cleared) on bad input
+    bool setFen(const std::string& fen);
+    std::string fen() const;
+
+    // EPD: the first four FEN fields, then operations ("bm Nf3; id \"x\";").
+    // setEpd hands the operations text to ops and takes the clocks from the
+    // hmvc / fmvn operations when present; epd() appends ops if not empty
+    bool setEpd(const std::string& epd, std::string* ops = nullptr);
+    std::string epd(const std::string& ops = "") const;
+
+    // compact copy without history; unpack() rebuilds everything else
+    void pack(PackedPosition& pp) const;
+    void unpack(const PackedPosition& pp);
+
+    // board editing, keeps the hash key and evaluation sums in sync
+    void putPiece(Piece pc, Square s);
+    void removePiece(Square s);
+    void movePiece(Square from, Square to);
+
+    // play a legal move for the side to move / take back the last one
+    void makeMove(Move m);
+    void unmakeMove();
+
+    // queries
+    Piece pieceOn(Square s) const { return board[s]; }
+    bool empty(Square s) const { return board[s] == NO_PIECE; }
+    Bitboard pieces() const { return occupied; }
+    Bitboard pieces(Color c) const { return byColor[c]; }
+    Bitboard pieces(Color c, PieceType pt) const { return byPiece[makePiece(c, pt)]; }
+    Bitboard pieces(PieceType pt) const { return byPiece[makePiece(WHITE, pt)] | byPiece[makePiece(BLACK, pt)]; }
+    Square kingSquare(Color c) const { return kingSq[c]; }
+    int count(Piece pc) const { return pieceCount[pc]; }
+
+    Color sideToMove() const { return side; }
+    int castlingRights() const { return castling; }
+    Square epSquare() const { return epSq; }
+    int rule50Count() const { return rule50; }
+    int gamePly() const { return ply; }
+
+    // zobrist key of the position, updated incrementally
+    uint64_t key() const { return hashKey; }
+
+    // zobrist key of the pawns alone, for the pawn structure cache
+    uint64_t pawnKey() const { return pawnHashKey; }
+
+    // material + piece-square sums (white minus black) and game phase for
+    // the evaluation, updated incrementally like the key
+    int psqMg() const { return mgScore; }
+    int psqEg() const { return egScore; }
+    int phase() const { return phaseWeight; }
+
+    // position occurred before since the last capture or pawn move
+    bool isRepetition() const;
+
+    // moves played since the position was set up
+    int historySize() const { return (int)history.size(); }
+    Move lastMove() const { return history.empty() ? MOVE_NONE : history.back().move; }
+
+    // record of move i (0 = first move made); its key is the position before it
+    const UndoInfo& undoAt(int i) const { return history[i]; }
+
+    // pieces of both colours attacking s with the given occupancy
+    Bitboard attackersTo(Square s, Bitboard occ) const;
+    Bitboard attackersTo(Square s) const { return attackersTo(s, occupied); }
+    bool inCheck() const { return checkersBB != 0; }
+
+    // check info for the side to move, refreshed after every move
+    Bitboard checkers() const { return checkersBB; }
+    Bitboard pinned() const { return pinnedBB; }
+    void updateCheckInfo();
+
+    // piece a move would take, NO_PIECE for quiet moves
+    Piece capturedBy(Move m) const;
+
+    // char view for drawing, view[row][col] with row 0 = rank 8
+    void toBoardView(char view[8][8]) const;
+
+private:
+    void setCastling(int rights);
+    void setEpSquare(Square s);
+
+    Bitboard byPiece[PIECE_NB];
+    Bitboard byColor[COLOR_NB];
+    Bitboard occupied;
+    Piece board[64];
+    Square kingSq[COLOR_NB];
+    int pieceCount[PIECE_NB];
+
+    Color side;
+    int castling;
+    Square epSq;
+    int rule50;
+    int ply;
+    uint64_t hashKey;
+    uint64_t pawnHashKey;
+    int mgScore;
+    int egScore;
+    int phaseWeight;
+
+    Bitboard checkersBB;  // enemy pieces giving check
+    Bitboard pinnedBB;    // our pieces pinned to our king
+
+    std::vector<UndoInfo> history;  // undo stack, one record per move made
+};
@@ -0,0 +1,424 @@
+#include <cstring>
+#include "Evaluate.h"
+#include "Search.h"
+#include "Tablebase.h"
+
+using namespace std;
+
+// lazy smp: helper threads skip some iterations so that at any moment the
+// threads are spread over different depths and fill the shared table with
+// different subtrees (pattern per helper, cycling after 20 helpers)
+static const int SkipSize[20]  = { 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4 };
+static const int SkipPhase[20] = { 0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7 };
+
+// endgame table result as a score, mates counted from the root; mates
+// too far away for the mate range stay just below it
+static int tbScore(const TbResult& r, int ply) {
+    if (r.wdl == TB_DRAW) {
+        return 0;
+    }
+    int plies = ply + r.dtm;
+    int score = plies < MAX_PLY ? VALUE_MATE - plies : VALUE_MATE_IN_MAX_PLY - 1;
+    return r.wdl == TB_WIN ? score : -score;
+}
+
+string formatInfo(const SearchInfo& info) {
+    string out = "info depth " + to_string(info.depth) + " seldepth " + to_string(info.seldepth);
+    if (abs(info.score) >= VALUE_MATE_IN_MAX_PLY) {
+        // moves, not plies, and negative when we are getting mated
+        int plies = VALUE_MATE - abs(info.score);
+        int moves = (plies + 1) / 2;
+        out += " score mate " + to_string(info.score > 0 ? moves : -moves);
+    }
+    else {
+        out += " score cp " + to_string(info.score);
+    }
+    out += " nodes " + to_string(info.nodes) + " nps " + to_string(info.nps)
+         + " hashfull " + to_string(info.hashfull) + " time " + to_string(info.timeMs);
+    if (!info.pv.empty()) {
+        out += " pv";
+        for (Move m : info.pv) {
+            out += " " + moveToString(m);
+        }
+    }
+    return out;
+}
+
+Search::Search(TranspositionTable& table, atomic<bool>* sharedStop, int id, atomic<uint64_t>* sharedNodeCount)
+    : tt(&table), pos(nullptr), ownStop(false), stopFlag(sharedStop ? sharedStop : &ownStop), threadId(id),
+      nodes(0), sharedNodes(sharedNodeCount), seldepth(0), rootDepth(0), prevPvLength(0), useNnue(false) {
+    memset(killers, 0, sizeof(killers));
+    memset(history, 0, sizeof(history));
+}
+
+int Search::elapsedMs() const {
+    return (int)chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - startTime).count();
+}
+
+// polled from the tree, the clock is read only every 1024 nodes
+bool Search::timeUp() {
+    if (*stopFlag) {
+        return true;
+    }
+    if (rootDepth <= 1) {
+        return false; // always finish depth 1 so there is a move to play
+    }
+    uint64_t n = nodesSearched();
+    // in a parallel search the limit counts every thread's nodes, which
+    // the shared counter lags by less than a batch per other thread
+    uint64_t total = sharedNodes ? sharedNodes->load(memory_order_relaxed) + (n & (NodeBatch - 1)) : n;
+    if (limits.nodes && total >= limits.nodes) {
+        *stopFlag = true;
+    }
+    else if (limits.movetime && (n & 1023) == 0 && elapsedMs() >= limits.movetime) {
+        *stopFlag = true;
+    }
+    return *stopFlag;
+}
+
+void Search::ageHistory() {
+    for (int c = 0; c < COLOR_NB; c++) {
+        for (int from = 0; from < 64; from++) {
+            for (int to = 0; to < 64; to++) {
+                history[c][from][to] /= 2;
+            }
+        }
+    }
+}
+
+// pv move, then captures by MVV-LVA, then killers, then quiet history
+void Search::orderMoves(MoveList& list, Move pvMove, int ply) {
+    int scores[MAX_MOVES];
+    Color us = pos->sideToMove();
+
+    for (int i = 0; i < list.count; i++) {
+        Move m = list.moves[i];
+        Piece captured = pos->capturedBy(m);
+        if (m == pvMove) {
+            scores[i] = 1 << 30;
+        }
+        else if (captured != NO_PIECE || typeOfMove(m) == PROMOTION) {
+            int victim = captured == NO_PIECE ? 0 : typeOf(captured) + 1;
+            int attacker = typeOf(pos->pieceOn(fromSq(m)));
+            scores[i] = (1 << 28) + victim * 16 - attacker + (typeOfMove(m) == PROMOTION ? promotionType(m) * 32 : 0);
+        }
+        else if (m == killers[ply][0]) {
+            scores[i] = (1 << 27) + 1;
+        }
+        else if (m == killers[ply][1]) {
+            scores[i] = 1 << 27;
+        }
+        else {
+            scores[i] = history[us][fromSq(m)][toSq(m)];
+        }
+    }
+
+    // insertion sort, lists are short
+    for (int i = 1; i < list.count; i++) {
+        Move m = list.moves[i];
+        int sc = scores[i];
+        int j = i - 1;
+        while (j >= 0 && scores[j] < sc) {
+            list.moves[j + 1] = list.moves[j];
+            scores[j + 1] = scores[j];
+            j--;
+        }
+        list.moves[j + 1] = m;
+        scores[j + 1] = sc;
+    }
+}
+
+int Search::staticEval() {
+    return useNnue ? nnue.evaluate(*pos) : evaluate(*pos, &pawns);
+}
+
+int Search::qsearch(int alpha, int beta, int ply) {
+    countNode();
+    pvLength[ply] = ply;
+    if (ply > seldepth) {
+        seldepth = ply;
+    }
+    if (timeUp()) {
+        return 0;
+    }
+    if (ply >= MAX_PLY) {
+        return staticEval();
+    }
+
+    // any stored search of this position is at least as deep as quiescence
+    bool pvNode = beta - alpha > 1;
+    TTData tte;
+    Move ttMove = MOVE_NONE;
+    if (tt->probe(pos->key(), tte)) {
+        ttMove = tte.move;
+        int ttScore = scoreFromTT(tte.score, ply);
+        if (!pvNode && (((tte.bound & BOUND_LOWER) && ttScore >= beta) || ((tte.bound & BOUND_UPPER) && ttScore <= alpha))) {
+            return ttScore;
+        }
+    }
+
+    // in check every evasion is searched and there is no stand pat
+    bool inCheck = pos->inCheck();
+    MoveList moves;
+    if (inCheck) {
+        generateLegalMoves(*pos, moves);
+        if (moves.size() == 0) {
+            return -VALUE_MATE + ply;
+        }
+    }
+    else {
+        int standPat = staticEval();
+        if (standPat >= beta) {
+            return standPat;
+        }
+        if (standPat > alpha) {
+            alpha = standPat;
+        }
+        generateLegalCaptures(*pos, moves);
+    }
+
+    int origAlpha = alpha;
+    Move bestMove = MOVE_NONE;
+    orderMoves(moves, ttMove, ply);
+    for (Move m : moves) {
+        pos->makeMove(m);
+        int score = -qsearch(-beta, -alpha, ply + 1);
+        pos->unmakeMove();
+        if (*stopFlag) {
+            return 0;
+        }
+        if (score > alpha) {
+            alpha = score;
+            bestMove = m;
+            if (alpha >= beta) {
+                break;
+            }
+        }
+    }
+
+    Bound bound = alpha >= beta ? BOUND_LOWER : alpha > origAlpha ? BOUND_EXACT : BOUND_UPPER;
+    tt->store(pos->key(), bestMove, scoreToTT(alpha, ply), 0, bound);
+    return alpha;
+}
+
+int Search::negamax(int alpha, int beta, int depth, int ply) {
+    pvLength[ply] = ply;
+
+    if (ply > 0) {
+        // repetition and fifty-move draws
+        if (pos->isRepetition() || pos->rule50Count() >= 100) {
+            return 0;
+        }
+        // mate distance pruning
+        alpha = max(alpha, -VALUE_MATE + ply);
+        beta = min(beta, VALUE_MATE - ply - 1);
+        if (alpha >= beta) {
+            return alpha;
+        }
+        // a small ending the tables cover needs no search
+        TbResult tb;
+        if (popcount(pos->pieces()) <= tbMaxPieces() && tbProbe(*pos, tb)) {
+            return tbScore(tb, ply);
+        }
+    }
+
+    bool inCheck = pos->inCheck();
+    if (inCheck) {
+        depth++; // check extension
+    }
+    if (depth <= 0 || ply >= MAX_PLY) {
+        return qsearch(alpha, beta, ply);
+    }
+
+    countNode();
+    if (timeUp()) {
+        return 0;
+    }
+
+    // a deep enough stored bound ends the node outside the pv; pv nodes
+    // are always searched so the triangular table keeps a full line
+    bool pvNode = beta - alpha > 1;
+    TTData tte;
+    Move ttMove = MOVE_NONE;
+    if (tt->probe(pos->key(), tte)) {
+        ttMove = tte.move;
+        int ttScore = scoreFromTT(tte.score, ply);
+        if (!pvNode && tte.depth >= depth
+            && (((tte.bound & BOUND_LOWER) && ttScore >= beta) || ((tte.bound & BOUND_UPPER) && ttScore <= alpha))) {
+            return ttScore;
+        }
+    }
+
+    MoveList moves;
+    generateLegalMoves(*pos, moves);
+    if (moves.size() == 0) {
+        return inCheck ? -VALUE_MATE + ply : 0;
+    }
+
+    // the table move is only a hint, it is looked up in the legal list
+    Move pvMove = ttMove != MOVE_NONE ? ttMove : ply < prevPvLength ? prevPv[ply] : MOVE_NONE;
+    orderMoves(moves, pvMove, ply);
+
+    Color us = pos->sideToMove();
+    int origAlpha = alpha;
+    int bestScore = -VALUE_INFINITE;
+    Move bestMove = MOVE_NONE;
+    for (int i = 0; i < moves.size(); i++) {
+        Move m = moves[i];
+        bool quiet = pos->capturedBy(m) == NO_PIECE && typeOfMove(m) != PROMOTION;
+
+        pos->makeMove(m);
+        int score;
+        if (i == 0) {
+            score = -negamax(-beta, -alpha, depth - 1, ply + 1);
+        }
+        else {
+            // principal variation search: prove the move is worse with a
+            // null window, re-search only when it is not
+            score = -negamax(-alpha - 1, -alpha, depth - 1, ply + 1);
+            if (score > alpha && score < beta) {
+                score = -negamax(-beta, -alpha, depth - 1, ply + 1);
+            }
+        }
+        pos->unmakeMove();
+
+        if (*stopFlag) {
+            return 0;
+        }
+
+        if (score > bestScore) {
+            bestScore = score;
+            if (score > alpha) {
+                alpha = score;
+                bestMove = m;
+
+                // pv = this move followed by the child's line
+                pvTable[ply][ply] = m;
+                for (int j = ply + 1; j < pvLength[ply + 1]; j++) {
+                    pvTable[ply][j] = pvTable[ply + 1][j];
+                }
+                pvLength[ply] = pvLength[ply + 1];
+
+                if (alpha >= beta) {
+                    if (quiet) {
+                        if (killers[ply][0] != m) {
+                            killers[ply][1] = killers[ply][0];
+                            killers[ply][0] = m;
+                        }
+                        int& h = history[us][fromSq(m)][toSq(m)];
+                        h += depth * depth;
+                        if (h > (1 << 26)) {
+                            ageHistory(); // stay below the killer scores
+                        }
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    Bound bound = bestScore >= beta ? BOUND_LOWER : bestScore > origAlpha ? BOUND_EXACT : BOUND_UPPER;
+    tt->store(pos->key(), bestMove, scoreToTT(bestScore, ply), depth, bound);
+    return bestScore;
+}
+
+SearchResult Search::think(Position& position, const SearchLimits& lim, InfoCallback onInfo) {
+    pos = &position;
+    limits = lim;
+    startTime = chrono::steady_clock::now();
+    nodes = 0;
+    seldepth = 0;
+    prevPvLength = 0;
+    if (stopFlag == &ownStop) {
+        // standalone search; in a parallel search the pool resets the shared
+        // flag and ages the table once for all threads
+        ownStop = false;
+        tt->newSearch();
+    }
+    memset(killers, 0, sizeof(killers));
+    memset(history, 0, sizeof(history));
+    pawns.resetStats();
+
+    SearchResult result;
+    MoveList rootMoves;
+    generateLegalMoves(position, rootMoves);
+    if (rootMoves.size() == 0) {
+        return result; // mate or stalemate, nothing to search
+    }
+    result.bestMove = rootMoves[0];
+
+    int maxDepth = (limits.depth > 0 && limits.depth < MAX_PLY) ? limits.depth : MAX_PLY;
+    int score = 0;
+
+    for (rootDepth = 1; rootDepth <= maxDepth; rootDepth++) {
+        if (threadId > 0 && rootDepth > 1) {
+            int i = (threadId - 1) % 20;
+            if (((rootDepth + position.gamePly() + SkipPhase[i]) / SkipSize[i]) % 2) {
+                continue;
+            }
+        }
+
+        // aspiration window around the last score once it is stable
+        int delta = 25;
+        int alpha = -VALUE_INFINITE;
+        int beta = VALUE_INFINITE;
+        if (rootDepth >= 4) {
+            alpha = max(score - delta, -VALUE_INFINITE);
+            beta = min(score + delta, VALUE_INFINITE);
+        }
+
+        while (true) {
+            score = negamax(alpha, beta, rootDepth, 0);
+            if (*stopFlag) {
+                break;
+            }
+            if (score <= alpha) {
+                alpha = max(score - delta, -VALUE_INFINITE);
+            }
+            else if (score >= beta) {
+                beta = min(score + delta, VALUE_INFINITE);
+            }
+            else {
+                break;
+            }
+            delta *= 2;
+        }
+        if (*stopFlag) {
+            break; // keep the last completed iteration
+        }
+
+        prevPvLength = pvLength[0];
+        for (int i = 0; i < prevPvLength; i++) {
+            prevPv[i] = pvTable[0][i];
+        }
+
+        result.bestMove = pvTable[0][0];
+        result.score = score;
+        result.depth = rootDepth;
+        result.pv.assign(prevPv, prevPv + prevPvLength);
+
+        if (onInfo) {
+            SearchInfo info;
+            info.depth = rootDepth;
+            info.seldepth = seldepth;
+            info.score = score;
+            info.nodes = nodesSearched();
+            info.timeMs = elapsedMs();
+            info.nps = info.timeMs > 0 ? info.nodes * 1000 / info.timeMs : info.nodes;
+            info.hashfull = tt->hashfull();
+            info.pv = result.pv;
+            onInfo(info);
+        }
+
+        // a found mate will not get shorter by searching deeper
+        if (abs(score) >= VALUE_MATE_IN_MAX_PLY && rootDepth >= VALUE_MATE - abs(score)) {
+            break;
+        }
+        if (limits.movetime && elapsedMs() >= limits.movetime) {
+            break;
+        }
+    }
+
+    result.nodes = nodesSearched();
+    return result;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include "MoveGen.h"
+#include "Nnue.h"
+#include "Pawns.h"
+#include "TT.h"
+
+const int MAX_PLY = 128;
+const int VALUE_INFINITE = 32001;
+const int VALUE_MATE = 32000;
+const int VALUE_MATE_IN_MAX_PLY = VALUE_MATE - MAX_PLY;
+
+// zero means "no limit" for every field; with no limit at all the search
+// runs until stop() is called or MAX_PLY is reached
+struct SearchLimits {
+    int depth = 0;
+    uint64_t nodes = 0;
+    int movetime = 0; // milliseconds
+};
+
+// progress report sent after every completed iteration
+struct SearchInfo {
+    int depth = 0;
+    int seldepth = 0;
+    int score = 0;
+    uint64_t nodes = 0;
+    int timeMs = 0;
+    uint64_t nps = 0;
+    int hashfull = 0; // permille
+    std::vector<Move> pv;
+};
+
+struct SearchResult {
+    Move bestMove = MOVE_NONE;
+    int score = 0;
+    int depth = 0;
+    uint64_t nodes = 0;
+    std::vector<Move> pv;
+};
+
+typedef std::function<void(const SearchInfo&)> InfoCallback;
+
+// "info depth 8 seldepth 14 score cp 35 nodes ... nps ... hashfull ... time ... pv e2e4 ..."
+std::string formatInfo(const SearchInfo& info);
+
+// negamax alpha-beta with iterative deepening, aspiration windows and
+// quiescence search; one object per searching thread, the transposition
+// table is owned by the caller and may be shared between searches.
+// Threads of one parallel search pass the same stop flag, the same node
+// counter (the node limit is judged on its total) and their own threadId
+// (0 for the thread that reports).
+class Search {
+public:
+    explicit Search(TranspositionTable& tt, std::atomic<bool>* sharedStop = nullptr, int threadId = 0,
+                    std::atomic<uint64_t>* sharedNodes = nullptr);
+
+    // search pos (restored on return) and return the best line found
+    SearchResult think(Position& pos, const SearchLimits& limits, InfoCallback onInfo = nullptr);
+
+    // ask a running think() to return as soon as possible, callable from any thread
+    void stop() { *stopFlag = true; }
+
+    // nodes of the current / last think(), safe to read from other threads
+    uint64_t nodesSearched() const { return nodes.load(std::memory_order_relaxed); }
+
+    // this thread's pawn structure cache, counters cover the last think()
+    const PawnTable& pawnTable() const { return pawns; }
+
+    // evaluate with the network instead of the handcrafted terms (nnueInit()
+    // must have run); not while thinking
+    void setUseNnue(bool on) { useNnue = on; nnue.reset(); }
+
+private:
+    int negamax(int alpha, int beta, int depth, int ply);
+    int qsearch(int alpha, int beta, int ply);
+    int staticEval();
+    void orderMoves(MoveList& list, Move pvMove, int ply);
+    void ageHistory();
+    bool timeUp();
+    int elapsedMs() const;
+
+    // only the owning thread writes its counter, so a plain load/store is
+    // enough; the shared counter gets whole batches of NodeBatch nodes
+    static const uint64_t NodeBatch = 1024;
+    void countNode() {
+        uint64_t n = nodes.load(std::memory_order_relaxed) + 1;
+        nodes.store(n, std::memory_order_relaxed);
+        if (sharedNodes && (n & (NodeBatch - 1)) == 0) {
+            sharedNodes->fetch_add(NodeBatch, std::memory_order_relaxed);
+        }
+    }
+
+    TranspositionTable* tt;
+    Position* pos;
+    SearchLimits limits;
+    std::chrono::steady_clock::time_point startTime;
+    std::atomic<bool> ownStop;
+    std::atomic<bool>* stopFlag;
+    int threadId;
+    std::atomic<uint64_t> nodes;
+    std::atomic<uint64_t>* sharedNodes;
+    int seldepth;
+    int rootDepth;
+
+    // triangular pv table, pvTable[ply] holds the line from that ply on
+    Move pvTable[MAX_PLY + 1][MAX_PLY + 1];
+    int pvLength[MAX_PLY + 1];
+    Move prevPv[MAX_PLY + 1];
+    int prevPvLength;
+
+    PawnTable pawns;
+    NnueEvaluator nnue;
+    bool useNnue;
+
+    // move ordering
+    Move killers[MAX_PLY + 1][2];
+    int history[COLOR_NB][64][64];
+};
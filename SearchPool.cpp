@@ -0,0 +1,81 @@
+#include <thread>
+#include "SearchPool.h"
+
+using namespace std;
+
+SearchPool::SearchPool(TranspositionTable& table, int threads) : tt(&table), stopFlag(false), nodeTotal(0), useNnue(false) {
+    setThreads(threads);
+}
+
+void SearchPool::setThreads(int n) {
+    if (n < 1) {
+        n = 1;
+    }
+    searches.clear();
+    for (int i = 0; i < n; i++) {
+        searches.emplace_back(new Search(*tt, &stopFlag, i, &nodeTotal));
+        searches.back()->setUseNnue(useNnue);
+    }
+}
+
+void SearchPool::setUseNnue(bool on) {
+    useNnue = on;
+    for (auto& s : searches) {
+        s->setUseNnue(on);
+    }
+}
+
+uint64_t SearchPool::nodesSearched() const {
+    uint64_t total = 0;
+    for (const auto& s : searches) {
+        total += s->nodesSearched();
+    }
+    return total;
+}
+
+double SearchPool::pawnHashHitRate() const {
+    uint64_t hits = 0, probes = 0;
+    for (const auto& s : searches) {
+        hits += s->pawnTable().hits();
+        probes += s->pawnTable().probes();
+    }
+    return probes ? (double)hits / probes : 0.0;
+}
+
+SearchResult SearchPool::think(const Position& pos, const SearchLimits& limits, InfoCallback onInfo) {
+    stopFlag = false;
+    nodeTotal = 0;
+    tt->newSearch();
+
+    // helpers run until thread 0 is done; the time limit is judged by
+    // thread 0 alone, the node limit by every thread against the nodes of
+    // all threads
+    SearchLimits helperLimits;
+    helperLimits.depth = limits.depth;
+    helperLimits.nodes = limits.nodes;
+
+    vector<Position> copies(searches.size(), pos);
+    vector<thread> helpers;
+    for (size_t i = 1; i < searches.size(); i++) {
+        helpers.emplace_back([this, i, &copies, &helperLimits] {
+            searches[i]->think(copies[i], helperLimits);
+        });
+    }
+
+    SearchResult result = searches[0]->think(copies[0], limits, [this, &onInfo](const SearchInfo& info) {
+        if (!onInfo) {
+            return;
+        }
+        SearchInfo total = info;
+        total.nodes = nodesSearched();
+        total.nps = total.timeMs > 0 ? total.nodes * 1000 / total.timeMs : total.nodes;
+        onInfo(total);
+    });
+
+    stopFlag = true;
+    for (thread& t : helpers) {
+        t.join();
+    }
+    result.nodes = nodesSearched();
+    return result;
+}
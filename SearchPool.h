@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "Search.h"
+
+// lazy smp: every thread runs a full Search on its own copy of the position
+// with its own ordering tables and stack, and they cooperate only through
+// the shared transposition table. Thread 0 reports and picks the move; when
+// it stops, the shared stop flag ends the helpers too. Every thread adds its
+// nodes to a shared counter, so a node limit covers the whole pool.
+class SearchPool {
+public:
+    explicit SearchPool(TranspositionTable& tt, int threads = 1);
+
+    // number of searching threads including the reporting one, at least 1;
+    // must not be called while think() is running
+    void setThreads(int n);
+    int threadCount() const { return (int)searches.size(); }
+
+    // blocks until the search ends; info and result carry the nodes of all threads
+    SearchResult think(const Position& pos, const SearchLimits& limits, InfoCallback onInfo = nullptr);
+
+    // callable from any thread
+    void stop() { stopFlag = true; }
+
+    uint64_t nodesSearched() const;
+
+    // network evaluation on every thread, see Search::setUseNnue()
+    void setUseNnue(bool on);
+
+    // pawn cache hit rate over all threads for the last think()
+    double pawnHashHitRate() const;
+
+private:
+    TranspositionTable* tt;
+    std::atomic<bool> stopFlag;
+    std::atomic<uint64_t> nodeTotal;  // all threads' nodes, in batches
+    bool useNnue;
+    std::vector<std::unique_ptr<Search>> searches;
+};
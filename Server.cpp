@@ -0,0 +1,669 @@
+// headless game server (Linux): TCP connections on epoll event loops, a
+// line protocol for creating, joining and playing games, and the games
+// themselves in a GamePool, so the rules are checked server-side.
+//
+// usage: server [--port N] [--loops N] [--workers N]
+//   --loops N    event loops, each on its own SO_REUSEPORT socket (default 1)
+//   --workers N  GamePool threads applying moves (default 1)
+//
+// protocol, one command per line:
+//   new [white|black]   -> game <id> white|black|both (no colour: play both sides)
+//   join <id>           -> game <id> <colour>; the creator gets joined <id>
+//   move <id> e2e4      -> update <id> e2e4 ok|check|checkmate|stalemate <fen>
+//                          to both players, or illegal <id> to the mover
+//   board <id>          -> board <id> <fen> playing|white|black|draw
+//   close <id>          -> closed <id> to both players
+//   quit
+// errors come back as "error <text>"; they are sent at once, while replies
+// from the pool follow when the game's worker gets to the request
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "GamePool.h"
+
+using namespace std;
+
+struct ServerOptions {
+    int port = 7777;
+    int loops = 1;
+    int workers = 1;
+};
+
+// longest command line a client may send
+const size_t MaxLineLength = 4096;
+
+// epoll tags that are not connections
+const uint64_t ListenTag = 0;
+const uint64_t WakeTag = 1;
+
+// game ids on the wire: slot index in the high half, generation in the low
+uint64_t gameId(GameHandle h) {
+    return (uint64_t(h.index) << 32) | h.generation;
+}
+
+GameHandle gameHandle(uint64_t id) {
+    GameHandle h = { uint32_t(id >> 32), uint32_t(id) };
+    return h;
+}
+
+const char* resultName(MoveResult r) {
+    switch (r) {
+    case MOVE_CHECK: return "check";
+    case MOVE_CHECKMATE: return "checkmate";
+    case MOVE_STALEMATE: return "stalemate";
+    default: return "ok";
+    }
+}
+
+const char* statusName(GameStatus s) {
+    switch (s) {
+    case GAME_WHITE_WINS: return "white";
+    case GAME_BLACK_WINS: return "black";
+    case GAME_DRAW: return "draw";
+    default: return "playing";
+    }
+}
+
+// "e2e4" / "e7e8q"; the promotion letter may be left out for a queen
+bool parseCoordinates(const string& str, Square& from, Square& to, PieceType& promo) {
+    if (str.size() < 4 || str.size() > 5
+        || str[0] < 'a' || str[0] > 'h' || str[1] < '1' || str[1] > '8'
+        || str[2] < 'a' || str[2] > 'h' || str[3] < '1' || str[3] > '8') {
+        return false;
+    }
+    from = makeSquare(str[0] - 'a', str[1] - '1');
+    to = makeSquare(str[2] - 'a', str[3] - '1');
+    promo = QUEEN;
+    if (str.size() == 5) {
+        switch (str[4]) {
+        case 'n': promo = KNIGHT; break;
+        case 'b': promo = BISHOP; break;
+        case 'r': promo = ROOK; break;
+        case 'q': promo = QUEEN; break;
+        default: return false;
+        }
+    }
+    return true;
+}
+
+struct Connection {
+    int fd;
+    uint64_t id;  // loop index in the top 16 bits
+    string in;
+    string out;
+    bool wantWrite = false;
+    vector<uint64_t> games;  // games this connection sits at
+};
+
+// who plays each colour of a game (connection ids, 0 = free seat)
+struct Table {
+    uint64_t player[COLOR_NB];
+};
+
+class Server;
+
+// one epoll loop: accepts on its own listening socket, reads commands and
+// writes replies. Replies from the pool workers arrive through the outbox
+// and an eventfd wake-up.
+class EventLoop {
+public:
+    EventLoop(Server& server, int index, int listenFd);
+    ~EventLoop();
+
+    void run();
+    void post(uint64_t conn, const string& line);
+
+private:
+    void accept();
+    void read(Connection& c);
+    void handleLine(Connection& c, const string& line, vector<GameRequest>& batch);
+    void flush(Connection& c);
+    void drop(Connection& c);
+    void drainOutbox();
+    void setListening(bool on);
+
+    Server& server;
+    int index;
+    int listenFd;
+    int epollFd;
+    int wakeFd;
+    int spareFd;  // held back to turn clients away when out of descriptors
+    bool listening;
+    uint64_t nextSerial;
+    unordered_map<uint64_t, unique_ptr<Connection>> conns;
+
+    mutex outboxMutex;
+    vector<pair<uint64_t, string>> outbox;
+};
+
+class Server {
+public:
+    explicit Server(const ServerOptions& opts);
+    int run();
+
+    // queue a line for a connection on any loop; id 0 is nobody
+    void post(uint64_t conn, const string& line);
+
+    GamePool pool;
+    mutex tablesMutex;
+    unordered_map<uint64_t, Table> tables;
+
+private:
+    void deliver(const vector<GameReply>& replies);
+
+    ServerOptions opts;
+    vector<unique_ptr<EventLoop>> loops;
+};
+
+// --- event loop ---
+
+EventLoop::EventLoop(Server& s, int i, int fd)
+    : server(s), index(i), listenFd(fd), listening(true), nextSerial(2) {
+    epollFd = epoll_create1(0);
+    wakeFd = eventfd(0, EFD_NONBLOCK);
+    spareFd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.u64 = ListenTag;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev);
+    ev.data.u64 = WakeTag;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev);
+}
+
+EventLoop::~EventLoop() {
+    for (auto& kv : conns) {
+        close(kv.second->fd);
+    }
+    if (spareFd >= 0) {
+        close(spareFd);
+    }
+    close(wakeFd);
+    close(epollFd);
+    close(listenFd);
+}
+
+// any thread; the loop writes it out after its next wake-up
+void EventLoop::post(uint64_t conn, const string& line) {
+    bool wake;
+    {
+        lock_guard<mutex> lock(outboxMutex);
+        wake = outbox.empty();
+        outbox.emplace_back(conn, line);
+    }
+    if (wake) {
+        uint64_t one = 1;
+        ssize_t n = write(wakeFd, &one, sizeof(one));
+        (void)n;
+    }
+}
+
+void EventLoop::run() {
+    epoll_event events[256];
+    while (true) {
+        int n = epoll_wait(epollFd, events, 256, -1);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            cout << "epoll_wait failed: " << strerror(errno) << endl;
+            return;
+        }
+        for (int i = 0; i < n; i++) {
+            uint64_t tag = events[i].data.u64;
+            if (tag == ListenTag) {
+                accept();
+                continue;
+            }
+            if (tag == WakeTag) {
+                drainOutbox();
+                continue;
+            }
+            auto it = conns.find(tag);
+            if (it == conns.end()) {
+                continue;
+            }
+            Connection& c = *it->second;
+            if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                drop(c);
+                continue;
+            }
+            if (events[i].events & EPOLLOUT) {
+                flush(c);
+                if (!conns.count(tag)) {
+                    continue; // dropped on a write error
+                }
+            }
+            if (events[i].events & EPOLLIN) {
+                read(c);
+            }
+        }
+    }
+}
+
+void EventLoop::accept() {
+    while (true) {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK);
+        if (fd < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return;
+            }
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            if ((errno == EMFILE || errno == ENFILE) && spareFd >= 0) {
+                // out of descriptors: give up the spare to accept and close
+                // the waiting client, otherwise it stays readable forever.
+                // EMFILE comes before EAGAIN, so stop once nobody is waiting
+                close(spareFd);
+                fd = accept4(listenFd, nullptr, nullptr, 0);
+                if (fd >= 0) {
+                    close(fd);
+                }
+                spareFd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+                if (fd < 0) {
+                    return;
+                }
+                continue;
+            }
+            // no spare either: stop listening until a connection closes
+            cout << "accept failed: " << strerror(errno) << endl;
+            setListening(false);
+            return;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        unique_ptr<Connection> c(new Connection());
+        c->fd = fd;
+        c->id = (uint64_t(index) << 48) | nextSerial++;
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.u64 = c->id;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+        conns[c->id] = move(c);
+    }
+}
+
+void EventLoop::read(Connection& c) {
+    // every complete line; the moves of one read go to the pool as a batch
+    vector<GameRequest> batch;
+    char buf[16384];
+    while (true) {
+        ssize_t n = recv(c.fd, buf, sizeof(buf), 0);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+            server.pool.submit(batch.data(), batch.size());
+            drop(c);
+            return;
+        }
+        if (n < 0) {
+            break;
+        }
+        c.in.append(buf, n);
+        size_t start = 0, end;
+        while ((end = c.in.find('\n', start)) != string::npos) {
+            string line = c.in.substr(start, end - start);
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            start = end + 1;
+            if (line == "quit") {
+                server.pool.submit(batch.data(), batch.size());
+                drop(c);
+                return;
+            }
+            handleLine(c, line, batch);
+        }
+        c.in.erase(0, start);
+        // no command is this long, so the client isn't speaking the protocol
+        if (c.in.size() > MaxLineLength) {
+            server.pool.submit(batch.data(), batch.size());
+            drop(c);
+            return;
+        }
+    }
+    if (!batch.empty()) {
+        server.pool.submit(batch.data(), batch.size());
+    }
+    flush(c);
+}
+
+void EventLoop::handleLine(Connection& c, const string& line, vector<GameRequest>& batch) {
+    istringstream in(line);
+    string cmd;
+    uint64_t id = 0;
+    in >> cmd;
+    if (cmd.empty()) {
+        return;
+    }
+
+    if (cmd == "new") {
+        string colour;
+        in >> colour;
+        GameHandle h;
+        if (!server.pool.create(h)) {
+            c.out += "error server full\n";
+            return;
+        }
+        id = gameId(h);
+        Table t = { { c.id, c.id } };
+        if (colour == "white") {
+            t.player[BLACK] = 0;
+        }
+        else if (colour == "black") {
+            t.player[WHITE] = 0;
+        }
+        else {
+            colour = "both";
+        }
+        {
+            lock_guard<mutex> lock(server.tablesMutex);
+            server.tables[id] = t;
+        }
+        c.games.push_back(id);
+        c.out += "game " + to_string(id) + " " + colour + "\n";
+        return;
+    }
+
+    if (cmd != "join" && cmd != "move" && cmd != "board" && cmd != "close") {
+        c.out += "error unknown command " + cmd + "\n";
+        return;
+    }
+    if (!(in >> id)) {
+        c.out += "error expected: " + cmd + " <id>\n";
+        return;
+    }
+    GameRequest req = { gameHandle(id), REQUEST_QUERY, 0, 0, 0, COLOR_NB, c.id };
+
+    lock_guard<mutex> lock(server.tablesMutex);
+    auto it = server.tables.find(id);
+    if (it == server.tables.end()) {
+        c.out += "error no such game " + to_string(id) + "\n";
+        return;
+    }
+    Table& t = it->second;
+
+    if (cmd == "join") {
+        Color free = t.player[WHITE] == 0 ? WHITE : t.player[BLACK] == 0 ? BLACK : COLOR_NB;
+        if (free == COLOR_NB) {
+            c.out += "error game " + to_string(id) + " is full\n";
+            return;
+        }
+        uint64_t other = t.player[~free];
+        t.player[free] = c.id;
+        c.games.push_back(id);
+        c.out += "game " + to_string(id) + (free == WHITE ? " white\n" : " black\n");
+        if (other != 0) {
+            server.post(other, "joined " + to_string(id));
+        }
+    }
+    else if (cmd == "move") {
+        string text;
+        Square from, to;
+        PieceType promo;
+        in >> text;
+        if (!parseCoordinates(text, from, to, promo)) {
+            c.out += "error bad move " + text + "\n";
+            return;
+        }
+        bool white = t.player[WHITE] == c.id, black = t.player[BLACK] == c.id;
+        if (!white && !black) {
+            c.out += "error not playing game " + to_string(id) + "\n";
+            return;
+        }
+        req.type = REQUEST_MOVE;
+        req.from = uint8_t(from);
+        req.to = uint8_t(to);
+        req.promo = uint8_t(promo);
+        req.side = uint8_t(white && black ? COLOR_NB : white ? WHITE : BLACK);
+        batch.push_back(req);
+    }
+    else if (cmd == "board") {
+        batch.push_back(req);
+    }
+    else {
+        if (t.player[WHITE] != c.id && t.player[BLACK] != c.id) {
+            c.out += "error not playing game " + to_string(id) + "\n";
+            return;
+        }
+        req.type = REQUEST_CLOSE;
+        batch.push_back(req);
+        c.games.erase(remove(c.games.begin(), c.games.end(), id), c.games.end());
+    }
+}
+
+void EventLoop::flush(Connection& c) {
+    while (!c.out.empty()) {
+        ssize_t n = send(c.fd, c.out.data(), c.out.size(), MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            drop(c);
+            return;
+        }
+        c.out.erase(0, n);
+    }
+    // only ask for EPOLLOUT while there is something left to send
+    bool want = !c.out.empty();
+    if (want != c.wantWrite) {
+        c.wantWrite = want;
+        epoll_event ev = {};
+        uint32_t mask = EPOLLIN;
+        if (want) {
+            mask |= EPOLLOUT;
+        }
+        ev.events = mask;
+        ev.data.u64 = c.id;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, c.fd, &ev);
+    }
+}
+
+// leaves every game the connection sat at; a game nobody sits at is closed
+void EventLoop::drop(Connection& c) {
+    vector<GameRequest> closes;
+    {
+        lock_guard<mutex> lock(server.tablesMutex);
+        for (uint64_t id : c.games) {
+            auto it = server.tables.find(id);
+            if (it == server.tables.end()) {
+                continue;
+            }
+            Table& t = it->second;
+            for (int col = WHITE; col <= BLACK; col++) {
+                if (t.player[col] == c.id) {
+                    t.player[col] = 0;
+                }
+            }
+            uint64_t other = t.player[WHITE] ? t.player[WHITE] : t.player[BLACK];
+            if (other) {
+                server.post(other, "left " + to_string(id));
+            }
+            else {
+                server.tables.erase(it);
+                GameRequest req = { gameHandle(id), REQUEST_CLOSE, 0, 0, 0, COLOR_NB, 0 };
+                closes.push_back(req);
+            }
+        }
+    }
+    server.pool.submit(closes.data(), closes.size());
+
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, c.fd, nullptr);
+    close(c.fd);
+    conns.erase(c.id);
+
+    if (!listening) {
+        if (spareFd < 0) {
+            spareFd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+        }
+        setListening(true);
+    }
+}
+
+void EventLoop::setListening(bool on) {
+    epoll_event ev = {};
+    ev.events = on ? uint32_t(EPOLLIN) : 0;
+    ev.data.u64 = ListenTag;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, listenFd, &ev);
+    listening = on;
+}
+
+void EventLoop::drainOutbox() {
+    uint64_t count;
+    ssize_t n = ::read(wakeFd, &count, sizeof(count));
+    (void)n;
+
+    vector<pair<uint64_t, string>> lines;
+    {
+        lock_guard<mutex> lock(outboxMutex);
+        lines.swap(outbox);
+    }
+    vector<Connection*> touched;
+    for (auto& l : lines) {
+        auto it = conns.find(l.first);
+        if (it == conns.end()) {
+            continue; // gone meanwhile
+        }
+        Connection& c = *it->second;
+        if (c.out.empty()) {
+            touched.push_back(&c);
+        }
+        c.out += l.second;
+        c.out += '\n';
+    }
+    for (Connection* c : touched) {
+        flush(*c);
+    }
+}
+
+// --- server ---
+
+Server::Server(const ServerOptions& o)
+    : pool(o.workers, [this](const vector<GameReply>& r) { deliver(r); }), opts(o) {
+}
+
+// the loop index is the top of the connection id
+void Server::post(uint64_t conn, const string& line) {
+    size_t loop = conn >> 48;
+    if (conn != 0 && loop < loops.size()) {
+        loops[loop]->post(conn, line);
+    }
+}
+
+// pool worker thread: turns a batch of replies into protocol lines
+void Server::deliver(const vector<GameReply>& replies) {
+    Position pos;
+    lock_guard<mutex> lock(tablesMutex);
+    for (const GameReply& r : replies) {
+        uint64_t id = gameId(r.game);
+        string ids = to_string(id);
+        if (!r.found) {
+            post(r.tag, "error no such game " + ids);
+            continue;
+        }
+        auto it = tables.find(id);
+        uint64_t white = it != tables.end() ? it->second.player[WHITE] : 0;
+        uint64_t black = it != tables.end() ? it->second.player[BLACK] : 0;
+
+        string line;
+        if (r.type == REQUEST_MOVE) {
+            if (r.result == MOVE_ILLEGAL) {
+                post(r.tag, "illegal " + ids);
+                continue;
+            }
+            pos.unpack(r.state.pos);
+            line = "update " + ids + " " + moveToString(r.move) + " " + resultName(r.result) + " " + pos.fen();
+        }
+        else if (r.type == REQUEST_QUERY) {
+            pos.unpack(r.state.pos);
+            post(r.tag, "board " + ids + " " + pos.fen() + " " + statusName(GameStatus(r.state.state)));
+            continue;
+        }
+        else {
+            line = "closed " + ids;
+            if (it != tables.end()) {
+                tables.erase(it);
+            }
+            if (white == 0 && black == 0) {
+                post(r.tag, line);
+            }
+        }
+        post(white, line);
+        if (black != white) {
+            post(black, line);
+        }
+    }
+}
+
+int Server::run() {
+    for (int i = 0; i < opts.loops; i++) {
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (opts.loops > 1) {
+            setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+        }
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(opts.port);
+        if (bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, 1024) < 0) {
+            cout << "cannot listen on port " << opts.port << ": " << strerror(errno) << endl;
+            close(fd);
+            return 1;
+        }
+        loops.push_back(unique_ptr<EventLoop>(new EventLoop(*this, i, fd)));
+    }
+    cout << "listening on port " << opts.port << " with " << opts.loops << " loop(s), "
+         << pool.workerCount() << " worker(s)" << endl;
+
+    vector<thread> threads;
+    for (size_t i = 1; i < loops.size(); i++) {
+        threads.emplace_back([this, i] { loops[i]->run(); });
+    }
+    loops[0]->run();
+    for (auto& t : threads) {
+        t.join();
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    initBitboards();
+    signal(SIGPIPE, SIG_IGN);
+
+    ServerOptions opts;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string arg = argv[i];
+        if (arg == "--port") {
+            opts.port = atoi(argv[i + 1]);
+        }
+        else if (arg == "--loops") {
+            opts.loops = max(1, atoi(argv[i + 1]));
+        }
+        else if (arg == "--workers") {
+            opts.workers = max(1, atoi(argv[i + 1]));
+        }
+    }
+
+    Server server(opts);
+    return server.run();
+}
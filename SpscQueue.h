@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// fixed-capacity ring for exactly one producer thread and one consumer
+// thread, without locks: head is only written by the consumer, tail only by
+// the producer. N must be a power of two.
+template <typename T, size_t N>
+class SpscQueue {
+public:
+    SpscQueue() : head(0), tail(0) {}
+
+    // producer side, false when full
+    bool push(const T& item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == N) {
+            return false;
+        }
+        items[t & (N - 1)] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer side, false when empty
+    bool pop(T& item) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = std::move(items[h & (N - 1)]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // either side; only a hint for the producer, exact for the consumer
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+private:
+    static_assert((N & (N - 1)) == 0, "capacity must be a power of two");
+
+    alignas(64) std::atomic<size_t> head;  // next item to pop
+    alignas(64) std::atomic<size_t> tail;  // next slot to fill
+    T items[N];
+};
@@ -0,0 +1,204 @@
+#include <cstdlib>
+#include <cstring>
+#include "Search.h"
+#include "TT.h"
+
+#if defined(_WIN32)
+#include <malloc.h>
+#elif defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+using namespace std;
+
+// data word layout: move 16 | score 16 | depth 8 | bound 2 | generation 6
+namespace {
+
+uint64_t packData(Move move, int score, int depth, Bound bound, uint8_t gen) {
+    return (uint64_t)move
+         | ((uint64_t)(uint16_t)(int16_t)score << 16)
+         | ((uint64_t)(uint8_t)depth << 32)
+         | ((uint64_t)bound << 40)
+         | ((uint64_t)(gen & 63) << 42);
+}
+
+Move dataMove(uint64_t d) { return Move(d & 0xFFFF); }
+int dataScore(uint64_t d) { return (int16_t)((d >> 16) & 0xFFFF); }
+int dataDepth(uint64_t d) { return (int)((d >> 32) & 0xFF); }
+Bound dataBound(uint64_t d) { return Bound((d >> 40) & 3); }
+uint8_t dataGen(uint64_t d) { return (uint8_t)((d >> 42) & 63); }
+
+// one big aligned block; on linux large blocks are aligned to 2 MB and
+// advised as transparent huge pages to cut TLB misses on random probes
+void* allocLarge(size_t size) {
+#if defined(_WIN32)
+    return _aligned_malloc(size, 64);
+#else
+    size_t align = size >= (2u << 20) ? (2u << 20) : 64;
+    size = (size + align - 1) / align * align;
+    void* mem = aligned_alloc(align, size);
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (mem && align > 64) {
+        madvise(mem, size, MADV_HUGEPAGE);
+    }
+#endif
+    return mem;
+#endif
+}
+
+void freeLarge(void* mem) {
+#if defined(_WIN32)
+    _aligned_free(mem);
+#else
+    free(mem);
+#endif
+}
+
+} // namespace
+
+int scoreToTT(int score, int ply) {
+    if (score >= VALUE_MATE_IN_MAX_PLY) {
+        return score + ply;
+    }
+    if (score <= -VALUE_MATE_IN_MAX_PLY) {
+        return score - ply;
+    }
+    return score;
+}
+
+int scoreFromTT(int score, int ply) {
+    if (score >= VALUE_MATE_IN_MAX_PLY) {
+        return score - ply;
+    }
+    if (score <= -VALUE_MATE_IN_MAX_PLY) {
+        return score + ply;
+    }
+    return score;
+}
+
+TranspositionTable::TranspositionTable() : table(nullptr), bucketCount(0), megabytes(0), generation(0) {
+}
+
+TranspositionTable::~TranspositionTable() {
+    release();
+}
+
+void TranspositionTable::release() {
+    if (table) {
+        freeLarge(table);
+        table = nullptr;
+    }
+    bucketCount = 0;
+}
+
+void TranspositionTable::resize(size_t mb) {
+    if (mb == 0) {
+        mb = 1;
+    }
+    if (mb == megabytes && table) {
+        return;
+    }
+    release();
+    size_t bytes = mb * 1024 * 1024;
+    table = (TTBucket*)allocLarge(bytes);
+    if (!table) {
+        megabytes = 0;
+        return;
+    }
+    bucketCount = bytes / sizeof(TTBucket);
+    megabytes = mb;
+    clear();
+}
+
+void TranspositionTable::clear() {
+    if (table) {
+        memset((void*)table, 0, bucketCount * sizeof(TTBucket));
+    }
+    generation = 0;
+}
+
+// multiply-shift maps the key onto [0, bucketCount) without a division
+TTBucket* TranspositionTable::bucketFor(uint64_t key) const {
+#if defined(__SIZEOF_INT128__)
+    return &table[(size_t)(((unsigned __int128)key * bucketCount) >> 64)];
+#else
+    return &table[(size_t)(((key >> 32) * (uint64_t)bucketCount) >> 32)];
+#endif
+}
+
+bool TranspositionTable::probe(uint64_t key, TTData& out) const {
+    if (!table) {
+        return false;
+    }
+    TTBucket* b = bucketFor(key);
+    for (int i = 0; i < TT_BUCKET_SIZE; i++) {
+        uint64_t data = b->entries[i].data.load(memory_order_relaxed);
+        uint64_t check = b->entries[i].keyXorData.load(memory_order_relaxed);
+        if ((check ^ data) == key && dataBound(data) != BOUND_NONE) {
+            out.move = dataMove(data);
+            out.score = dataScore(data);
+            out.depth = dataDepth(data);
+            out.bound = dataBound(data);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key, Move move, int score, int depth, Bound bound) {
+    if (!table) {
+        return;
+    }
+    TTBucket* b = bucketFor(key);
+
+    // same position first, otherwise the shallowest / oldest entry;
+    // each generation of age counts as 8 plies of depth
+    TTEntry* victim = &b->entries[0];
+    int victimWorth = 1 << 30;
+    for (int i = 0; i < TT_BUCKET_SIZE; i++) {
+        TTEntry& e = b->entries[i];
+        uint64_t data = e.data.load(memory_order_relaxed);
+        if ((e.keyXorData.load(memory_order_relaxed) ^ data) == key) {
+            victim = &e;
+            // keep the old best move when this store has none, and do not
+            // let a shallow non-exact result overwrite deeper work
+            if (move == MOVE_NONE) {
+                move = dataMove(data);
+            }
+            if (bound != BOUND_EXACT && depth + 4 < dataDepth(data) && dataGen(data) == generation) {
+                return;
+            }
+            break;
+        }
+        int age = (generation - dataGen(data)) & 63;
+        int worth = dataBound(data) == BOUND_NONE ? -1000 : dataDepth(data) - 8 * age;
+        if (worth < victimWorth) {
+            victimWorth = worth;
+            victim = &e;
+        }
+    }
+
+    if (depth < 0) {
+        depth = 0;
+    }
+    uint64_t data = packData(move, score, depth, bound, generation);
+    victim->keyXorData.store(key ^ data, memory_order_relaxed);
+    victim->data.store(data, memory_order_relaxed);
+}
+
+int TranspositionTable::hashfull() const {
+    if (!table) {
+        return 0;
+    }
+    int used = 0;
+    size_t sample = bucketCount < 250 ? bucketCount : 250;
+    for (size_t i = 0; i < sample; i++) {
+        for (int j = 0; j < TT_BUCKET_SIZE; j++) {
+            uint64_t data = table[i].entries[j].data.load(memory_order_relaxed);
+            if (dataBound(data) != BOUND_NONE && dataGen(data) == generation) {
+                used++;
+            }
+        }
+    }
+    return sample ? (int)(used * 1000 / (sample * TT_BUCKET_SIZE)) : 0;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include "Move.h"
+
+enum Bound : uint8_t {
+    BOUND_NONE,
+    BOUND_UPPER,  // fail low, score is at most this
+    BOUND_LOWER,  // fail high, score is at least this
+    BOUND_EXACT = BOUND_UPPER | BOUND_LOWER
+};
+
+// decoded table entry
+struct TTData {
+    Move move;
+    int score;
+    int depth;
+    Bound bound;
+};
+
+// 16-byte entry stored as (key ^ data, data). A reader only trusts the data
+// when xoring the two words gives back its key, so a torn write from another
+// thread reads as a miss instead of a wrong hit and no lock is needed.
+struct TTEntry {
+    std::atomic<uint64_t> keyXorData;
+    std::atomic<uint64_t> data;
+};
+
+// four entries per 64-byte bucket, one cache line per probe
+const int TT_BUCKET_SIZE = 4;
+
+struct alignas(64) TTBucket {
+    TTEntry entries[TT_BUCKET_SIZE];
+};
+
+// fixed-size hash table keyed by the zobrist key, shared by all search threads
+class TranspositionTable {
+public:
+    TranspositionTable();
+    ~TranspositionTable();
+
+    // (re)allocate to the given size in megabytes and clear, no-op if unchanged
+    void resize(size_t mb);
+    void clear();
+
+    // bump the age at the start of every search
+    void newSearch() { generation = (generation + 1) & 63; }
+
+    bool probe(uint64_t key, TTData& out) const;
+    void store(uint64_t key, Move move, int score, int depth, Bound bound);
+
+    // permille of sampled entries written during the current search
+    int hashfull() const;
+
+    size_t sizeMb() const { return megabytes; }
+
+private:
+    TTBucket* bucketFor(uint64_t key) const;
+    void release();
+
+    TTBucket* table;
+    size_t bucketCount;
+    size_t megabytes;
+    uint8_t generation;
+};
+
+// mate scores are stored relative to the node, not the root
+int scoreToTT(int score, int ply);
+int scoreFromTT(int score, int ply);
@@ -0,0 +1,755 @@
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include "MappedFile.h"
+#include "MoveGen.h"
+#include "Tablebase.h"
+
+using namespace std;
+
+// piece letters in name order, strongest first
+const char* const PieceLetters = "KQRBNP";
+const PieceType LetterType[6] = { KING, QUEEN, ROOK, BISHOP, KNIGHT, PAWN };
+const int LetterValue[6] = { 0, 9, 5, 3, 3, 1 };
+
+// generator codes, one byte per index slot while a table is built
+const uint8_t GEN_UNKNOWN = 0;
+const uint8_t GEN_BROKEN = 1;
+const uint8_t GEN_DRAW = 2;
+const uint8_t GEN_MATE = 3;  // GEN_MATE + d = mate in d plies
+const int MaxDtm = 252;
+
+// a1-d1-d4 triangle for the white king of pawnless tables
+static int TriIndex[64];
+static Square TriSquare[10];
+
+static struct TriangleInit {
+    TriangleInit() {
+        fill(TriIndex, TriIndex + 64, -1);
+        int n = 0;
+        for (int rank = 0; rank < 4; rank++) {
+            for (int file = rank; file < 4; file++) {
+                TriSquare[n] = makeSquare(file, rank);
+                TriIndex[TriSquare[n]] = n;
+                n++;
+            }
+        }
+    }
+} triangleInit;
+
+struct TbTable {
+    string name;
+    int count = 0;                // pieces, kings included
+    Piece pieces[TB_MAX_PIECES];  // white king, black king, White's others, Black's others
+    bool pawns = false;
+    uint64_t entries = 0;
+    MappedFile map;
+    const uint64_t* offsets = nullptr;
+    const uint8_t* data = nullptr;
+};
+
+static vector<unique_ptr<TbTable>> tables;
+static unordered_map<uint64_t, TbTable*> tableByKey;
+static int maxPieces = 0;
+
+static int letterIndex(char c) {
+    const char* at = c ? strchr(PieceLetters, c) : nullptr;
+    return at ? int(at - PieceLetters) : -1;
+}
+
+static int sideValue(const string& side) {
+    int v = 0;
+    for (char c : side) {
+        v += LetterValue[letterIndex(c)];
+    }
+    return v;
+}
+
+// > 0 if side a ("KQ") is stronger than side b: more material, then the
+// stronger pieces, then more of them
+static int compareSides(const string& a, const string& b) {
+    int va = sideValue(a), vb = sideValue(b);
+    if (va != vb) {
+        return va - vb;
+    }
+    for (size_t i = 1; i < a.size() && i < b.size(); i++) {
+        if (a[i] != b[i]) {
+            return letterIndex(b[i]) - letterIndex(a[i]);
+        }
+    }
+    return int(a.size()) - int(b.size());
+}
+
+// "KQvKR" -> pieces and index size, false for anything else
+static bool parseMaterial(const string& name, TbTable& t) {
+    size_t v = name.find('v');
+    if (v == string::npos) {
+        return false;
+    }
+    string sides[COLOR_NB] = { name.substr(0, v), name.substr(v + 1) };
+    t.count = 2;
+    t.pieces[0] = W_KING;
+    t.pieces[1] = B_KING;
+    t.pawns = false;
+    for (int c = WHITE; c <= BLACK; c++) {
+        const string& s = sides[c];
+        if (s.empty() || s[0] != 'K') {
+            return false;
+        }
+        int last = 1;
+        for (size_t i = 1; i < s.size(); i++) {
+            int k = letterIndex(s[i]);
+            if (k < last || t.count == TB_MAX_PIECES) {
+                return false;
+            }
+            last = k;
+            t.pieces[t.count++] = makePiece(Color(c), LetterType[k]);
+            t.pawns |= LetterType[k] == PAWN;
+        }
+    }
+    if (compareSides(sides[WHITE], sides[BLACK]) < 0) {
+        return false;
+    }
+    t.name = name;
+    t.entries = 2 * (t.pawns ? 32 : 10) * 64;
+    for (int i = 2; i < t.count; i++) {
+        t.entries *= typeOf(t.pieces[i]) == PAWN ? 48 : 64;
+    }
+    return true;
+}
+
+// piece counts of both sides in 4-bit fields, colours swapped when flip
+static uint64_t materialKey(const Position& pos, bool flip) {
+    uint64_t key = 0;
+    for (int c = WHITE; c <= BLACK; c++) {
+        for (int pt = PAWN; pt < KING; pt++) {
+            key |= uint64_t(pos.count(makePiece(Color(c ^ flip), PieceType(pt)))) << (4 * (5 * c + pt));
+        }
+    }
+    return key;
+}
+
+static uint64_t materialKey(const TbTable& t) {
+    uint64_t key = 0;
+    for (int i = 2; i < t.count; i++) {
+        key += 1ULL << (4 * (5 * colorOf(t.pieces[i]) + typeOf(t.pieces[i])));
+    }
+    return key;
+}
+
+static Square transpose(Square s) {
+    return ((s & 7) << 3) | (s >> 3);
+}
+
+// index slot of the position with the table's pieces on squares (slot
+// order) and stm to move, after turning it into the canonical orientation
+static uint64_t encode(const TbTable& t, const Square* squares, Color stm) {
+    Square sq[TB_MAX_PIECES] = {};
+    int flip = (fileOf(squares[0]) > 3 ? 7 : 0) | (!t.pawns && rankOf(squares[0]) > 3 ? 56 : 0);
+    for (int i = 0; i < t.count; i++) {
+        sq[i] = squares[i] ^ flip;
+    }
+    if (!t.pawns && (rankOf(sq[0]) > fileOf(sq[0]) || (rankOf(sq[0]) == fileOf(sq[0]) && rankOf(sq[1]) > fileOf(sq[1])))) {
+        for (int i = 0; i < t.count; i++) {
+            sq[i] = transpose(sq[i]);
+        }
+    }
+    if (t.count == 4 && t.pieces[2] == t.pieces[3] && sq[3] < sq[2]) {
+        swap(sq[2], sq[3]);
+    }
+
+    uint64_t idx = t.pawns ? stm * 32 + 4 * rankOf(sq[0]) + fileOf(sq[0]) : stm * 10 + TriIndex[sq[0]];
+    idx = idx * 64 + sq[1];
+    for (int i = 2; i < t.count; i++) {
+        idx = typeOf(t.pieces[i]) == PAWN ? idx * 48 + (sq[i] - 8) : idx * 64 + sq[i];
+    }
+    return idx;
+}
+
+static void decode(const TbTable& t, uint64_t idx, Square* sq, Color& stm) {
+    for (int i = t.count - 1; i >= 2; i--) {
+        if (typeOf(t.pieces[i]) == PAWN) {
+            sq[i] = Square(idx % 48 + 8);
+            idx /= 48;
+        }
+        else {
+            sq[i] = Square(idx % 64);
+            idx /= 64;
+        }
+    }
+    sq[1] = Square(idx % 64);
+    idx /= 64;
+    int kings = t.pawns ? 32 : 10;
+    int k = int(idx % kings);
+    stm = Color(idx / kings);
+    sq[0] = t.pawns ? makeSquare(k % 4, k / 4) : TriSquare[k];
+}
+
+// squares of the table's pieces in pos (slot order); with flip the table's
+// White is pos's Black and the board is mirrored
+static void tableSquares(const TbTable& t, const Position& pos, bool flip, Square* sq) {
+    for (int i = 0; i < t.count; i++) {
+        Piece pc = t.pieces[i];
+        Bitboard b = pos.pieces(Color(colorOf(pc) ^ flip), typeOf(pc));
+        if (i > 2 && pc == t.pieces[i - 1]) {
+            b &= b - 1;
+        }
+        sq[i] = flip ? lsb(b) ^ 56 : lsb(b);
+    }
+}
+
+// builds the position of slot idx; false for broken slots: two pieces on
+// one square, not the canonical slot of its position, or the side that
+// isn't to move in check
+static bool setupPosition(const TbTable& t, uint64_t idx, Position& pos, Square* sq, Color& stm) {
+    decode(t, idx, sq, stm);
+    Bitboard occ = 0;
+    for (int i = 0; i < t.count; i++) {
+        if (occ & squareBB(sq[i])) {
+            return false;
+        }
+        occ |= squareBB(sq[i]);
+    }
+    if (encode(t, sq, stm) != idx) {
+        return false;
+    }
+    PackedPosition pp;
+    memset(pp.board, NO_PIECE | (NO_PIECE << 4), sizeof(pp.board));
+    for (int i = 0; i < t.count; i++) {
+        int shift = 4 * (sq[i] & 1);
+        pp.board[sq[i] / 2] = uint8_t((pp.board[sq[i] / 2] & ~(15 << shift)) | (t.pieces[i] << shift));
+    }
+    pp.side = uint8_t(stm);
+    pp.castling = 0;
+    pp.epSq = NO_SQUARE;
+    pp.rule50 = 0;
+    pp.ply = 0;
+    pos.unpack(pp);
+    return !(pos.attackersTo(pos.kingSquare(~stm)) & pos.pieces(stm));
+}
+
+// value byte of slot idx from the run-length coded blocks
+static uint8_t tableByte(const TbTable& t, uint64_t idx) {
+    uint64_t block = idx / TbBlockSize;
+    uint64_t skip = idx % TbBlockSize;
+    const uint8_t* p = t.data + t.offsets[block];
+    const uint8_t* end = t.data + t.offsets[block + 1];
+    while (p < end) {
+        uint8_t value = *p++;
+        uint64_t run = 0;
+        for (int shift = 0; p < end; shift += 7) {
+            uint8_t b = *p++;
+            run |= uint64_t(b & 127) << shift;
+            if (!(b & 128)) {
+                break;
+            }
+        }
+        if (skip < run) {
+            return value;
+        }
+        skip -= run;
+    }
+    return 0;
+}
+
+int tbInit(const string& dir) {
+    tbClear();
+    if (dir.empty()) {
+        return 0;
+    }
+    int loaded = 0;
+    for (const string& name : tbMaterials(TB_MAX_PIECES)) {
+        loaded += tbAddFile(dir + "/" + name + ".mtb");
+    }
+    return loaded;
+}
+
+bool tbAddFile(const string& path) {
+    unique_ptr<TbTable> t(new TbTable);
+    if (!t->map.open(path) || t->map.size() < sizeof(TbFileHeader)) {
+        return false;
+    }
+    const TbFileHeader* h = (const TbFileHeader*)t->map.data();
+    char name[sizeof(h->material) + 1] = {};
+    memcpy(name, h->material, sizeof(h->material));
+    if (memcmp(h->magic, "MCHESSTB", 8) != 0 || h->version != TbVersion || h->blockSize != TbBlockSize
+        || !parseMaterial(name, *t) || h->entries != t->entries
+        || h->blocks != (t->entries + TbBlockSize - 1) / TbBlockSize) {
+        return false;
+    }
+    uint64_t dataStart = sizeof(TbFileHeader) + (h->blocks + 1) * sizeof(uint64_t);
+    if (t->map.size() < dataStart) {
+        return false;
+    }
+    t->offsets = (const uint64_t*)(t->map.data() + sizeof(TbFileHeader));
+    t->data = (const uint8_t*)(t->map.data() + dataStart);
+    if (t->offsets[h->blocks] > t->map.size() - dataStart) {
+        return false;
+    }
+
+    uint64_t key = materialKey(*t);
+    maxPieces = max(maxPieces, t->count);
+    tableByKey[key] = t.get();
+    for (unique_ptr<TbTable>& old : tables) {
+        if (materialKey(*old) == key) {
+            old = move(t);
+            return true;
+        }
+    }
+    tables.push_back(move(t));
+    return true;
+}
+
+void tbClear() {
+    tableByKey.clear();
+    tables.clear();
+    maxPieces = 0;
+}
+
+int tbMaxPieces() {
+    return maxPieces;
+}
+
+bool tbProbe(const Position& pos, TbResult& r) {
+    if (pos.castlingRights() || pos.epSquare() != NO_SQUARE) {
+        return false;
+    }
+    int n = popcount(pos.pieces());
+    if (n == 2) {
+        r = { TB_DRAW, 0 };
+        return true;
+    }
+    if (n > maxPieces) {
+        return false;
+    }
+    bool flip = false;
+    auto it = tableByKey.find(materialKey(pos, false));
+    if (it == tableByKey.end()) {
+        flip = true;
+        it = tableByKey.find(materialKey(pos, true));
+        if (it == tableByKey.end()) {
+            return false;
+        }
+    }
+    const TbTable& t = *it->second;
+    Square sq[TB_MAX_PIECES];
+    tableSquares(t, pos, flip, sq);
+    uint8_t v = tableByte(t, encode(t, sq, flip ? ~pos.sideToMove() : pos.sideToMove()));
+    if (!v) {
+        r = { TB_DRAW, 0 };
+    }
+    else {
+        r = { (v - 1) % 2 ? TB_WIN : TB_LOSS, v - 1 };
+    }
+    return true;
+}
+
+Move tbBestMove(Position& pos, TbResult* result) {
+    TbResult here;
+    if (!tbProbe(pos, here)) {
+        return MOVE_NONE;
+    }
+    MoveList moves;
+    generateLegalMoves(pos, moves);
+    Move best = MOVE_NONE;
+    int bestRank = INT_MIN;
+    for (Move m : moves) {
+        TbResult r;
+        pos.makeMove(m);
+        bool found = tbProbe(pos, r);
+        pos.unmakeMove();
+        if (!found) {
+            return MOVE_NONE;
+        }
+        // the quickest mate, else a draw, else the slowest loss
+        int rank = r.wdl == TB_LOSS ? 1000 - r.dtm : r.wdl == TB_DRAW ? 0 : r.dtm - 1000;
+        if (rank > bestRank) {
+            bestRank = rank;
+            best = m;
+        }
+    }
+    if (result) {
+        *result = here;
+    }
+    return best;
+}
+
+vector<string> tbMaterials(int pieces) {
+    pieces = min(pieces, TB_MAX_PIECES);
+    // one side's pieces besides the king, by count, in name order
+    vector<string> sides[TB_MAX_PIECES - 1];
+    sides[0].push_back("");
+    for (int n = 1; n <= pieces - 2; n++) {
+        for (const string& s : sides[n - 1]) {
+            for (int k = s.empty() ? 1 : letterIndex(s.back()); k < 6; k++) {
+                sides[n].push_back(s + PieceLetters[k]);
+            }
+        }
+    }
+    vector<string> names;
+    for (int n = 3; n <= pieces; n++) {
+        for (int a = n - 2; a >= 0; a--) {
+            for (const string& w : sides[a]) {
+                for (const string& b : sides[n - 2 - a]) {
+                    if (compareSides("K" + w, "K" + b) >= 0) {
+                        names.push_back("K" + w + "vK" + b);
+                    }
+                }
+            }
+        }
+    }
+    // captures lead to fewer pieces, promotions to fewer pawns
+    stable_sort(names.begin(), names.end(), [](const string& a, const string& b) {
+        if (a.size() != b.size()) {
+            return a.size() < b.size();
+        }
+        return count(a.begin(), a.end(), 'P') < count(b.begin(), b.end(), 'P');
+    });
+    return names;
+}
+
+// runs work(begin, end, thread) over [0, count) in chunks on threads threads
+static void parallelFor(uint64_t count, int threads, const function<void(uint64_t, uint64_t, int)>& work) {
+    const uint64_t Chunk = 4096;
+    atomic<uint64_t> next(0);
+    auto run = [&](int t) {
+        for (;;) {
+            uint64_t begin = next.fetch_add(Chunk);
+            if (begin >= count) {
+                break;
+            }
+            work(begin, min(count, begin + Chunk), t);
+        }
+    };
+    vector<thread> pool;
+    for (int t = 1; t < threads && uint64_t(t) * Chunk < count; t++) {
+        pool.emplace_back(run, t);
+    }
+    run(0);
+    for (thread& th : pool) {
+        th.join();
+    }
+}
+
+static bool leavesTable(const Position& pos, Move m) {
+    return pos.capturedBy(m) != NO_PIECE || typeOfMove(m) == PROMOTION;
+}
+
+// slots of the positions one quiet move before (sq, stm): a piece of the
+// side that just moved steps back to an empty square
+template<typename Visit>
+static void unmoves(const TbTable& t, const Square* sq, Color stm, Visit visit) {
+    Color them = ~stm;
+    Bitboard occ = 0;
+    for (int i = 0; i < t.count; i++) {
+        occ |= squareBB(sq[i]);
+    }
+    Square from[TB_MAX_PIECES];
+    copy(sq, sq + t.count, from);
+    for (int i = 0; i < t.count; i++) {
+        Piece pc = t.pieces[i];
+        if (colorOf(pc) != them) {
+            continue;
+        }
+        Bitboard origins = 0;
+        if (typeOf(pc) == PAWN) {
+            int up = them == WHITE ? 8 : -8;
+            Square back = sq[i] - up;
+            if (relativeRank(them, sq[i]) >= 2 && !(occ & squareBB(back))) {
+                origins |= squareBB(back);
+                if (relativeRank(them, sq[i]) == 3 && !(occ & squareBB(back - up))) {
+                    origins |= squareBB(back - up);
+                }
+            }
+        }
+        else {
+            origins = attacksBB(typeOf(pc), sq[i], occ) & ~occ;
+        }
+        while (origins) {
+            from[i] = popLsb(origins);
+            visit(encode(t, from, them));
+        }
+        from[i] = sq[i];
+    }
+}
+
+// true if slot idx mates in d plies (d odd) or is mated in d (d even),
+// judged by its moves into positions decided before pass d
+static bool resolves(const TbTable& t, uint64_t idx, int d, Position& pos, const atomic<uint8_t>* value) {
+    Square sq[TB_MAX_PIECES];
+    Color stm;
+    setupPosition(t, idx, pos, sq, stm);
+    MoveList moves;
+    generateLegalMoves(pos, moves);
+    bool wins = d & 1;
+    for (Move m : moves) {
+        int dtm = -1;  // the move's result if decided before this pass
+        bool leaves = leavesTable(pos, m);
+        pos.makeMove(m);
+        if (leaves) {
+            TbResult r;
+            if (tbProbe(pos, r) && r.wdl != TB_DRAW && r.dtm < d) {
+                dtm = r.dtm;
+            }
+        }
+        else {
+            Square child[TB_MAX_PIECES];
+            tableSquares(t, pos, false, child);
+            int code = value[encode(t, child, pos.sideToMove())].load(memory_order_relaxed);
+            if (code >= GEN_MATE && code - GEN_MATE < d) {
+                dtm = code - GEN_MATE;
+            }
+        }
+        pos.unmakeMove();
+        if (wins && dtm >= 0 && dtm % 2 == 0) {
+            return true;
+        }
+        if (!wins && !(dtm >= 0 && dtm % 2 == 1)) {
+            return false;
+        }
+    }
+    return !wins;
+}
+
+bool generateTablebase(const string& material, const string& path, int threads, TbGenStats* stats) {
+    TbTable t;
+    if (!parseMaterial(material, t) || t.count < 3) {
+        printf("invalid material %s\n", material.c_str());
+        return false;
+    }
+    if (threads <= 0) {
+        threads = max(1u, thread::hardware_concurrency());
+    }
+    uint64_t size = t.entries;
+    unique_ptr<atomic<uint8_t>[]> value(new atomic<uint8_t>[size]);
+    unique_ptr<atomic<uint8_t>[]> mark(new atomic<uint8_t>[size]);  // last pass the slot was a candidate in
+    vector<Position> positions(threads);
+    vector<vector<uint32_t>> found(threads);
+    vector<vector<uint32_t>> candidates(threads);
+    vector<vector<vector<uint32_t>>> triggers(threads, vector<vector<uint32_t>>(MaxDtm + 1));
+    atomic<bool> missing(false);
+    atomic<bool> tooLong(false);
+
+    // first pass: broken slots, mates and stalemates. Captures and
+    // promotions leave the table; what they lead to decides which pass
+    // has to look at the position again
+    parallelFor(size, threads, [&](uint64_t begin, uint64_t end, int th) {
+        Position& pos = positions[th];
+        Square sq[TB_MAX_PIECES];
+        Color stm;
+        for (uint64_t i = begin; i < end; i++) {
+            mark[i].store(0, memory_order_relaxed);
+            if (!setupPosition(t, i, pos, sq, stm)) {
+                value[i].store(GEN_BROKEN, memory_order_relaxed);
+                continue;
+            }
+            MoveList moves;
+            generateLegalMoves(pos, moves);
+            uint8_t code = GEN_UNKNOWN;
+            if (moves.size() == 0) {
+                code = pos.inCheck() ? GEN_MATE : GEN_DRAW;
+                if (pos.inCheck()) {
+                    found[th].push_back(uint32_t(i));
+                }
+            }
+            else {
+                int minLoss = INT_MAX, maxWin = -1;
+                bool exitDraw = false;
+                for (Move m : moves) {
+                    if (!leavesTable(pos, m)) {
+                        continue;
+                    }
+                    TbResult r;
+                    pos.makeMove(m);
+                    bool ok = tbProbe(pos, r);
+                    pos.unmakeMove();
+                    if (!ok) {
+                        missing = true;
+                    }
+                    else if (r.wdl == TB_LOSS) {
+                        minLoss = min(minLoss, r.dtm);
+                    }
+                    else if (r.wdl == TB_WIN) {
+                        maxWin = max(maxWin, r.dtm);
+                    }
+                    else {
+                        exitDraw = true;
+                    }
+                }
+                int pass = minLoss != INT_MAX ? minLoss + 1 : maxWin >= 0 && !exitDraw ? maxWin + 1 : 0;
+                if (pass > MaxDtm) {
+                    tooLong = true;
+                }
+                else if (pass) {
+                    triggers[th][pass].push_back(uint32_t(i));
+                }
+            }
+            value[i].store(code, memory_order_relaxed);
+        }
+    });
+    if (missing) {
+        printf("%s: a capture or promotion leads to a table that isn't loaded\n", material.c_str());
+        return false;
+    }
+
+    // pass d finds the positions mated in d plies (d even) or mating in d
+    // (d odd): the unresolved ones with a move into the last pass's results,
+    // plus those whose captures and promotions are decided by then
+    vector<uint32_t> frontier;
+    for (vector<uint32_t>& f : found) {
+        frontier.insert(frontier.end(), f.begin(), f.end());
+        f.clear();
+    }
+    int lastTrigger = 0;
+    for (int th = 0; th < threads; th++) {
+        for (int d = 1; d <= MaxDtm; d++) {
+            if (!triggers[th][d].empty()) {
+                lastTrigger = max(lastTrigger, d);
+            }
+        }
+    }
+    int maxDtm = 0;
+    vector<uint32_t> list;
+    for (int d = 1; !frontier.empty() || d <= lastTrigger; d++) {
+        if (d > MaxDtm) {
+            tooLong = true;
+            break;
+        }
+        parallelFor(frontier.size(), threads, [&](uint64_t begin, uint64_t end, int th) {
+            Square sq[TB_MAX_PIECES];
+            Color stm;
+            for (uint64_t k = begin; k < end; k++) {
+                auto visit = [&](uint64_t p) {
+                    if (value[p].load(memory_order_relaxed) == GEN_UNKNOWN
+                        && mark[p].exchange(uint8_t(d), memory_order_relaxed) != d) {
+                        candidates[th].push_back(uint32_t(p));
+                    }
+                };
+                decode(t, frontier[k], sq, stm);
+                unmoves(t, sq, stm, visit);
+                // with both kings on the diagonal a position and its mirror
+                // image have a slot each, the mirrored moves reach the other
+                if (!t.pawns) {
+                    for (int i = 0; i < t.count; i++) {
+                        sq[i] = transpose(sq[i]);
+                    }
+                    unmoves(t, sq, stm, visit);
+                }
+            }
+        });
+        list.clear();
+        for (int th = 0; th < threads; th++) {
+            list.insert(list.end(), candidates[th].begin(), candidates[th].end());
+            candidates[th].clear();
+            for (uint32_t p : triggers[th][d]) {
+                if (value[p].load(memory_order_relaxed) == GEN_UNKNOWN && mark[p].exchange(uint8_t(d)) != d) {
+                    list.push_back(p);
+                }
+            }
+            vector<uint32_t>().swap(triggers[th][d]);
+        }
+
+        parallelFor(list.size(), threads, [&](uint64_t begin, uint64_t end, int th) {
+            for (uint64_t k = begin; k < end; k++) {
+                if (resolves(t, list[k], d, positions[th], value.get())) {
+                    found[th].push_back(list[k]);
+                }
+            }
+        });
+        frontier.clear();
+        for (vector<uint32_t>& f : found) {
+            for (uint32_t p : f) {
+                value[p].store(uint8_t(GEN_MATE + d), memory_order_relaxed);
+            }
+            frontier.insert(frontier.end(), f.begin(), f.end());
+            f.clear();
+        }
+        if (!frontier.empty()) {
+            maxDtm = d;
+        }
+    }
+    if (tooLong) {
+        printf("%s: mates longer than %d plies don't fit the format\n", material.c_str(), MaxDtm);
+        return false;
+    }
+
+    // file bytes: draws and undecided positions 0, mates d + 1, broken
+    // slots the value before them so they extend its run
+    TbGenStats st;
+    st.entries = size;
+    st.maxDtm = maxDtm;
+    vector<uint8_t> data;
+    uint64_t blocks = (size + TbBlockSize - 1) / TbBlockSize;
+    vector<uint64_t> offsets;
+    offsets.reserve(blocks + 1);
+    uint8_t prev = 0;
+    vector<uint8_t> bytes(TbBlockSize);
+    for (uint64_t b = 0; b < blocks; b++) {
+        offsets.push_back(data.size());
+        uint64_t first = b * TbBlockSize, n = min<uint64_t>(TbBlockSize, size - first);
+        for (uint64_t i = 0; i < n; i++) {
+            uint8_t code = value[first + i].load(memory_order_relaxed);
+            if (code == GEN_BROKEN) {
+                bytes[i] = prev;
+                continue;
+            }
+            st.positions++;
+            if (code >= GEN_MATE) {
+                int d = code - GEN_MATE;
+                (d % 2 ? st.wins : st.losses)++;
+                bytes[i] = uint8_t(d + 1);
+            }
+            else {
+                st.draws++;
+                bytes[i] = 0;
+            }
+            prev = bytes[i];
+        }
+        for (uint64_t i = 0; i < n;) {
+            uint64_t j = i + 1;
+            while (j < n && bytes[j] == bytes[i]) {
+                j++;
+            }
+            data.push_back(bytes[i]);
+            for (uint64_t run = j - i;;) {
+                uint8_t low = run & 127;
+                run >>= 7;
+                data.push_back(uint8_t(low | (run ? 128 : 0)));
+                if (!run) {
+                    break;
+                }
+            }
+            i = j;
+        }
+    }
+    offsets.push_back(data.size());
+
+    TbFileHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, "MCHESSTB", 8);
+    h.version = TbVersion;
+    h.blockSize = TbBlockSize;
+    h.entries = size;
+    h.blocks = blocks;
+    memcpy(h.material, material.data(), min(material.size(), sizeof(h.material)));
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) {
+        printf("can't write %s\n", path.c_str());
+        return false;
+    }
+    bool ok = fwrite(&h, sizeof(h), 1, f) == 1
+           && fwrite(offsets.data(), sizeof(uint64_t), offsets.size(), f) == offsets.size()
+           && fwrite(data.data(), 1, data.size(), f) == data.size();
+    ok = fclose(f) == 0 && ok;
+    st.bytes = sizeof(h) + offsets.size() * sizeof(uint64_t) + data.size();
+    if (stats) {
+        *stats = st;
+    }
+    return ok;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Position.h"
+
+// ENDGAME TABLES
+// Distance-to-mate tables for endings of up to four pieces (kings
+// included), made by retrograde analysis and probed from memory-mapped
+// files. One file per material, e.g. "KQvKR.mtb", named with the stronger
+// side as White; positions where Black has that material are looked up
+// with the board mirrored and the colours swapped.
+//
+// Index: side to move, white king, black king, then the other pieces in
+// the order of the name. Without pawns the white king is mirrored into the
+// a1-d1-d4 triangle (10 squares), and the black king below the diagonal
+// when the white king is on it; with pawns only files are mirrored (white
+// king on files a-d) and pawns take ranks 2-7 only. Equal pieces are kept
+// in square order. Index slots no position maps to are "broken".
+//
+// One byte per position: 0 = draw, d + 1 = mate in d plies (the side to
+// move mates if d is odd and is mated if d is even). The bytes are run
+// length coded in blocks of TbBlockSize positions behind a table of block
+// offsets; broken slots repeat the value before them so runs stay long.
+// Castling and en passant are not in the tables, positions with castling
+// rights or an en passant square aren't probed.
+
+const int TB_MAX_PIECES = 4;
+const uint32_t TbVersion = 1;
+const uint32_t TbBlockSize = 4096;
+
+struct TbFileHeader {
+    char magic[8];       // "MCHESSTB"
+    uint32_t version;
+    uint32_t blockSize;
+    uint64_t entries;    // index size
+    uint64_t blocks;     // followed by blocks + 1 offsets into the data
+    char material[16];   // "KQvKR"
+    uint64_t reserved[2];
+};
+
+static_assert(sizeof(TbFileHeader) == 64, "file header is 64 bytes");
+
+enum TbWdl {
+    TB_LOSS = -1,
+    TB_DRAW = 0,
+    TB_WIN = 1
+};
+
+// result for the side to move
+struct TbResult {
+    TbWdl wdl;
+    int dtm;  // plies to mate with best play, 0 for draws
+};
+
+// maps every table up to TB_MAX_PIECES pieces found in dir (missing ones
+// are skipped); returns the number of tables loaded
+int tbInit(const std::string& dir);
+
+// maps one table file, replacing a loaded table of the same material;
+// false if it is missing or not a table
+bool tbAddFile(const std::string& path);
+
+// unmaps all tables
+void tbClear();
+
+// most pieces of any loaded table, 0 when none is loaded
+int tbMaxPieces();
+
+// looks pos up, false when no loaded table covers it. Thread-safe, but not
+// while tables are added or cleared.
+bool tbProbe(const Position& pos, TbResult& r);
+
+// move with the best table result (quickest mate, else a draw, else the
+// longest defence), MOVE_NONE when pos or one of its moves isn't covered;
+// r gets the result of pos
+Move tbBestMove(Position& pos, TbResult* r = nullptr);
+
+// table names of 3 up to pieces pieces, ordered so every table comes after
+// the ones its captures and promotions lead to
+std::vector<std::string> tbMaterials(int pieces);
+
+struct TbGenStats {
+    uint64_t entries = 0;   // index size
+    uint64_t positions = 0; // legal positions
+    uint64_t wins = 0;      // for the side to move
+    uint64_t losses = 0;
+    uint64_t draws = 0;
+    int maxDtm = 0;         // longest mate in plies
+    uint64_t bytes = 0;     // file size
+};
+
+// generates the table of material ("KRvK") into path with threads threads
+// (0 = all cores). The tables its captures and promotions lead to must be
+// loaded. False if the name is invalid, a table is missing or the file
+// can't be written.
+bool generateTablebase(const std::string& material, const std::string& path, int threads, TbGenStats* stats = nullptr);
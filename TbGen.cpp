@@ -0,0 +1,114 @@
+// headless endgame table tool: generates the distance-to-mate tables by
+// retrograde analysis and looks positions up in them
+//
+// usage: tbgen build <dir> [--pieces N] [--threads N] [--only KQvKR] [--force]
+//        tbgen probe <dir> --fen "<fen>"
+//   --pieces N   tables of up to N pieces, kings included (3 or 4, default 4)
+//   --threads N  generator threads (0 = all cores)
+//   --only name  just this table, the ones it leads to must be in dir
+//   --force      regenerate tables that already exist
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "MoveGen.h"
+#include "Tablebase.h"
+
+using namespace std;
+
+static void usage() {
+    cout << "usage: tbgen build <dir> [--pieces N] [--threads N] [--only KQvKR] [--force]" << endl;
+    cout << "       tbgen probe <dir> --fen \"<fen>\"" << endl;
+}
+
+static double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static string resultString(const TbResult& r) {
+    if (r.wdl == TB_DRAW) {
+        return "draw";
+    }
+    return string(r.wdl == TB_WIN ? "win" : "loss") + ", mate in " + to_string(r.dtm) + " plies";
+}
+
+int main(int argc, char* argv[]) {
+    initBitboards();
+    if (argc < 3) {
+        usage();
+        return 1;
+    }
+    string command = argv[1];
+    string dir = argv[2];
+    string fen;
+    string only;
+    int pieces = TB_MAX_PIECES;
+    int threads = 0;
+    bool force = false;
+    for (int i = 3; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--pieces" && i + 1 < argc) { pieces = atoi(argv[++i]); }
+        else if (arg == "--threads" && i + 1 < argc) { threads = atoi(argv[++i]); }
+        else if (arg == "--only" && i + 1 < argc) { only = argv[++i]; }
+        else if (arg == "--fen" && i + 1 < argc) { fen = argv[++i]; }
+        else if (arg == "--force") { force = true; }
+    }
+
+    if (command == "build") {
+        int existing = tbInit(dir);
+        vector<string> names = only.empty() ? tbMaterials(pieces) : vector<string>{ only };
+        cout << existing << " tables in " << dir << endl;
+        for (const string& name : names) {
+            string path = dir + "/" + name + ".mtb";
+            if (!force && only.empty() && tbAddFile(path)) {
+                continue;
+            }
+            auto start = chrono::steady_clock::now();
+            TbGenStats st;
+            if (!generateTablebase(name, path, threads, &st) || !tbAddFile(path)) {
+                cout << name << ": generation failed" << endl;
+                return 1;
+            }
+            double seconds = secondsSince(start);
+            cout << name << "\t" << st.positions << " positions (+" << st.wins << " =" << st.draws << " -"
+                 << st.losses << "), longest mate " << st.maxDtm << " plies, " << st.bytes << " bytes, "
+                 << seconds << " s, " << uint64_t(st.entries / max(seconds, 1e-6)) << " slots/s" << endl;
+        }
+        return 0;
+    }
+    if (command != "probe") {
+        usage();
+        return 1;
+    }
+
+    int loaded = tbInit(dir);
+    Position pos;
+    if (!pos.setFen(fen)) {
+        cout << "invalid fen: " << fen << endl;
+        return 1;
+    }
+    TbResult r;
+    auto start = chrono::steady_clock::now();
+    bool found = tbProbe(pos, r);
+    double us = secondsSince(start) * 1e6;
+    if (!found) {
+        cout << "not in the " << loaded << " tables" << endl;
+        return 1;
+    }
+    cout << resultString(r) << " (lookup " << us << " us)" << endl;
+
+    // best line by the tables until mate, or a few moves of a draw
+    string line;
+    for (int ply = 0; ply < 256; ply++) {
+        Move m = tbBestMove(pos);
+        if (m == MOVE_NONE || (r.wdl == TB_DRAW && ply >= 10)) {
+            break;
+        }
+        line += moveToSan(pos, m) + " ";
+        pos.makeMove(m);
+    }
+    cout << line << endl;
+    return 0;
+}
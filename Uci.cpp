@@ -0,0 +1,302 @@
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <thread>
+#include "Book.h"
+#include "Nnue.h"
+#include "SearchPool.h"
+#include "Tablebase.h"
+#include "Uci.h"
+
+using namespace std;
+
+bool setupNnue(const EngineOptions& opts) {
+    if (!opts.nnue) {
+        return false;
+    }
+    nnueInit();
+    if (!opts.nnueFile.empty() && !nnueLoad(opts.nnueFile)) {
+        cout << "info string could not load network " << opts.nnueFile << ", using the built-in one" << endl;
+    }
+    cout << "info string nnue evaluation, " << nnueKernelName(nnueKernel()) << " kernel" << endl;
+    return true;
+}
+
+bool setupBook(const EngineOptions& opts, OpeningBook& book) {
+    book.close();
+    if (!opts.bookKeys.empty() && !loadPolyglotRandoms(opts.bookKeys)) {
+        cout << "info string could not load polyglot keys " << opts.bookKeys << endl;
+    }
+    if (opts.bookFile.empty()) {
+        return false;
+    }
+    if (!book.open(opts.bookFile)) {
+        cout << "info string could not open book " << opts.bookFile << endl;
+        return false;
+    }
+    cout << "info string book " << opts.bookFile << ", " << book.entries() << " entries" << endl;
+    return true;
+}
+
+int setupTablebases(const EngineOptions& opts) {
+    int tables = tbInit(opts.tbPath);
+    if (!opts.tbPath.empty()) {
+        cout << "info string " << tables << " endgame tables in " << opts.tbPath << ", up to " << tbMaxPieces()
+             << " pieces" << endl;
+    }
+    return tables;
+}
+
+namespace {
+
+// one line to stdout at a time, the search thread prints too
+mutex outputMutex;
+
+void send(const string& line) {
+    lock_guard<mutex> lock(outputMutex);
+    cout << line << endl;
+}
+
+// the engine state one UCI session works on
+class UciEngine {
+public:
+    explicit UciEngine(const EngineOptions& opts);
+    ~UciEngine() { stopSearch(); }
+
+    void loop();
+
+private:
+    void cmdUci();
+    void cmdSetOption(istringstream& in);
+    void cmdPosition(istringstream& in);
+    void cmdGo(istringstream& in);
+    void stopSearch();
+
+    EngineOptions opts;
+    TranspositionTable tt;
+    SearchPool pool;
+    Position pos;
+    OpeningBook book;
+    bool ownBook;
+    mt19937_64 rng;  // book move choice
+
+    thread searcher;
+    // "go infinite" must not print bestmove before "stop" even when the
+    // search itself has finished
+    mutex stopMutex;
+    condition_variable stopCv;
+    bool stopRequested;
+};
+
+UciEngine::UciEngine(const EngineOptions& o)
+    : opts(o), pool(tt, o.threads), rng(random_device()()), stopRequested(false) {
+    tt.resize(opts.hashMb);
+    pool.setUseNnue(setupNnue(opts));
+    ownBook = setupBook(opts, book);
+    setupTablebases(opts);
+    pos.setStartPosition();
+}
+
+void UciEngine::cmdUci() {
+    send("id name MyCHESS");
+    send("id author MyCHESS developers");
+    send("option name Hash type spin default 16 min 1 max 65536");
+    send("option name Threads type spin default 1 min 1 max 512");
+    send("option name UseNNUE type check default false");
+    send("option name EvalFile type string default <empty>");
+    send(string("option name OwnBook type check default ") + (ownBook ? "true" : "false"));
+    send("option name BookFile type string default <empty>");
+    send("option name TablebasePath type string default <empty>");
+    send("uciok");
+}
+
+// setoption name <id> [value <x>]
+void UciEngine::cmdSetOption(istringstream& in) {
+    string token, name, value;
+    in >> token; // "name"
+    while (in >> token && token != "value") {
+        name += (name.empty() ? "" : " ") + token;
+    }
+    while (in >> token) {
+        value += (value.empty() ? "" : " ") + token;
+    }
+
+    if (name == "Hash") {
+        opts.hashMb = max(1, atoi(value.c_str()));
+        tt.resize(opts.hashMb);
+    }
+    else if (name == "Threads") {
+        opts.threads = max(1, atoi(value.c_str()));
+        pool.setThreads(opts.threads);
+    }
+    else if (name == "UseNNUE" || name == "EvalFile") {
+        if (name == "UseNNUE") {
+            opts.nnue = value == "true";
+        }
+        else {
+            opts.nnueFile = value == "<empty>" ? "" : value;
+        }
+        pool.setUseNnue(setupNnue(opts));
+    }
+    else if (name == "OwnBook") {
+        ownBook = value == "true";
+        if (ownBook && !book.isOpen()) {
+            setupBook(opts, book);
+        }
+    }
+    else if (name == "BookFile") {
+        opts.bookFile = value == "<empty>" ? "" : value;
+        setupBook(opts, book);
+    }
+    else if (name == "TablebasePath") {
+        opts.tbPath = value == "<empty>" ? "" : value;
+        setupTablebases(opts);
+    }
+    else {
+        send("info string unknown option " + name);
+    }
+}
+
+// position startpos | fen <fen> [moves <m1> ...]
+void UciEngine::cmdPosition(istringstream& in) {
+    string token, fen;
+    in >> token;
+    if (token == "startpos") {
+        fen = StartFEN;
+        in >> token; // "moves" or nothing
+    }
+    else if (token == "fen") {
+        while (in >> token && token != "moves") {
+            fen += token + " ";
+        }
+    }
+    else {
+        return;
+    }
+
+    // a bad fen keeps the current position
+    Position next;
+    if (!next.setFen(fen)) {
+        send("info string invalid fen");
+        return;
+    }
+    pos = next;
+    while (in >> token) {
+        Move m = parseMove(pos, token);
+        if (m == MOVE_NONE || (pos.capturedBy(m) != NO_PIECE && typeOf(pos.capturedBy(m)) == KING)) {
+            send("info string illegal move " + token);
+            return;
+        }
+        pos.makeMove(m);
+    }
+}
+
+// go [depth N] [nodes N] [movetime ms] [wtime ms btime ms winc ms binc ms movestogo N] [infinite]
+void UciEngine::cmdGo(istringstream& in) {
+    SearchLimits limits;
+    int time[COLOR_NB] = { 0, 0 };
+    int inc[COLOR_NB] = { 0, 0 };
+    int movesToGo = 0;
+    bool infinite = false;
+
+    string token;
+    while (in >> token) {
+        if (token == "depth") { in >> limits.depth; }
+        else if (token == "nodes") { in >> limits.nodes; }
+        else if (token == "movetime") { in >> limits.movetime; }
+        else if (token == "wtime") { in >> time[WHITE]; }
+        else if (token == "btime") { in >> time[BLACK]; }
+        else if (token == "winc") { in >> inc[WHITE]; }
+        else if (token == "binc") { in >> inc[BLACK]; }
+        else if (token == "movestogo") { in >> movesToGo; }
+        else if (token == "infinite") { infinite = true; }
+    }
+
+    // clock: an even share of what is left plus most of the increment,
+    // never closer than 50 ms to the flag
+    Color us = pos.sideToMove();
+    if (!limits.movetime && time[us] > 0) {
+        int share = time[us] / (movesToGo > 0 ? movesToGo + 1 : 30) + inc[us] * 3 / 4;
+        limits.movetime = max(1, min(share, time[us] - 50));
+    }
+
+    stopSearch();
+
+    // a book move costs a lookup, no search
+    if (ownBook && book.isOpen() && !infinite) {
+        Move m = book.pick(pos, rng());
+        if (m != MOVE_NONE) {
+            send("info string book move");
+            send("bestmove " + moveToString(m));
+            return;
+        }
+    }
+
+    // as does an ending the tables cover
+    if (!infinite) {
+        TbResult tb;
+        Move m = tbBestMove(pos, &tb);
+        if (m != MOVE_NONE) {
+            send("info string tablebase " + string(tb.wdl == TB_WIN ? "win" : tb.wdl == TB_LOSS ? "loss" : "draw")
+                 + (tb.wdl != TB_DRAW ? ", mate in " + to_string(tb.dtm) + " plies" : ""));
+            send("bestmove " + moveToString(m));
+            return;
+        }
+    }
+
+    stopRequested = false;
+    Position root = pos;
+    searcher = thread([this, root, limits, infinite] {
+        SearchResult result = pool.think(root, limits, [](const SearchInfo& info) {
+            send(formatInfo(info));
+        });
+        if (infinite) {
+            unique_lock<mutex> lock(stopMutex);
+            stopCv.wait(lock, [this] { return stopRequested; });
+        }
+        send("bestmove " + moveToString(result.bestMove));
+    });
+}
+
+void UciEngine::stopSearch() {
+    if (!searcher.joinable()) {
+        return;
+    }
+    {
+        lock_guard<mutex> lock(stopMutex);
+        stopRequested = true;
+    }
+    stopCv.notify_all();
+    pool.stop();
+    searcher.join();
+}
+
+void UciEngine::loop() {
+    string line;
+    while (getline(cin, line)) {
+        istringstream in(line);
+        string cmd;
+        in >> cmd;
+
+        if (cmd == "uci") { cmdUci(); }
+        else if (cmd == "isready") { send("readyok"); }
+        else if (cmd == "ucinewgame") { stopSearch(); tt.clear(); }
+        else if (cmd == "setoption") { stopSearch(); cmdSetOption(in); }
+        else if (cmd == "position") { stopSearch(); cmdPosition(in); }
+        else if (cmd == "go") { cmdGo(in); }
+        else if (cmd == "stop") { stopSearch(); }
+        else if (cmd == "quit") { break; }
+        else if (!cmd.empty()) { send("info string unknown command " + cmd); }
+    }
+    stopSearch();
+}
+
+} // namespace
+
+int runUci(EngineOptions opts) {
+    UciEngine engine(opts);
+    engine.loop();
+    return 0;
+}
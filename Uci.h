@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+
+// engine settings shared by the window, analysis and UCI modes
+struct EngineOptions {
+    int hashMb = 16;
+    int threads = 1;
+    bool nnue = false;
+    std::string nnueFile; // empty = compiled-in network
+    std::string bookFile; // Polyglot book the engine plays from, empty = none
+    std::string bookKeys; // Polyglot random table (text), empty = built-in
+    std::string tbPath;   // directory of endgame tables, empty = none
+};
+
+class OpeningBook;
+
+// load the network when opts ask for it; true if the engine should use it
+bool setupNnue(const EngineOptions& opts);
+
+// open opts.bookFile into book (closed when there is none); true if open
+bool setupBook(const EngineOptions& opts, OpeningBook& book);
+
+// map the endgame tables in opts.tbPath (none when empty), shared by every
+// search; not while one runs. Returns the number of tables.
+int setupTablebases(const EngineOptions& opts);
+
+// UCI protocol on stdin/stdout until "quit" or end of input. Commands are
+// read on the calling thread and searches run on their own thread, so
+// "stop" and "isready" are answered while the engine thinks. Needs only
+// initBitboards(), no window, textures or fonts.
+int runUci(EngineOptions opts);
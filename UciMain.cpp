@@ -0,0 +1,20 @@
+// headless UCI engine: the same protocol as "MyCHESS --uci" without linking
+// SFML, for servers and engine tournaments
+//
+// usage: uci [--book file] [--book-keys file] [--tb dir]
+
+#include <string>
+#include "Bitboard.h"
+#include "Uci.h"
+
+int main(int argc, char* argv[]) {
+    initBitboards();
+    EngineOptions opts;
+    for (int i = 1; i + 1 < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--book") { opts.bookFile = argv[++i]; }
+        else if (arg == "--book-keys") { opts.bookKeys = argv[++i]; }
+        else if (arg == "--tb") { opts.tbPath = argv[++i]; }
+    }
+    return runUci(opts);
+}